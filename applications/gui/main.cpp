@@ -53,7 +53,7 @@ int main(int argc, char* argv[])
 	editor.setMinimumSize(600, 600);
 	editor.setTabStopDistance(30);
 	editor.setUserDefined(userDefined);
-	editor.highlighter()->useLuaRules();
+	editor.highlighter()->useLuaLexer();
 	editor.setPlainText(R"~~(--Test for program 42
 num = 42
 text = 'foo'
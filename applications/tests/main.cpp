@@ -1,14 +1,20 @@
 #include "coloration_test.h"
+#include "memory_usage.h"
 
 #define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
 #include <doctest/doctest.h>
 
 #include <lac/parser/ast_adapted.h>
+#include <lac/parser/binary_ast.h>
+#include <lac/parser/json_writer.h>
 #include <lac/parser/parser.h>
 #include <lac/parser/positions.h>
 #include <lac/parser/printer.h>
 
+#include <chrono>
 #include <fstream>
+#include <iostream>
+#include <limits>
 
 #ifdef WIN32
 #include <windows.h>
@@ -74,6 +80,114 @@ namespace
 			std::cout << "json library not available\n";
 #endif
 	}
+
+	// Discards everything written in it
+	class NullBuffer : public std::streambuf
+	{
+	protected:
+		int overflow(int c) override { return c; }
+		std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+	};
+
+	// Compare the printer with the streaming json writer
+	void benchJson(std::string_view path, int iterations)
+	{
+		const auto data = loadFile(path);
+		if (data.empty())
+			return;
+
+		const auto ret = lac::parser::parseBlock(data, false);
+		if (!ret.parsed)
+			return;
+
+		auto bench = [&](const char* name, auto func) {
+			memory::resetPeak();
+			const auto before = memory::current();
+			size_t size = 0;
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; ++i)
+				size = func();
+			const auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			std::cout << name << ": " << duration / iterations << " ms, "
+					  << size / 1024 << " KB written, "
+					  << (memory::peak() - before) / 1024 << " KB peak memory\n";
+		};
+
+#ifdef WITH_NLOHMANN_JSON
+		bench("printer", [&] { return lac::toJson(ret.block).size(); });
+#endif
+		bench("writer", [&] {
+			std::string buffer;
+			lac::writeJson(buffer, ret.block);
+			return buffer.size();
+		});
+
+		NullBuffer nullBuffer;
+		std::ostream nullStream{&nullBuffer};
+		bench("writer (stream)", [&] {
+			lac::writeJson(nullStream, ret.block);
+			return size_t{0};
+		});
+	}
+
+	// Compare the full parsing with the validation of the syntax
+	void benchParse(std::string_view path, int iterations)
+	{
+		const auto data = loadFile(path);
+		if (data.empty())
+			return;
+
+		// The minimum duration is less sensitive to the noise of the machine than the mean
+		auto bench = [&](const char* name, auto func) {
+			memory::resetPeak();
+			const auto before = memory::current();
+			auto duration = std::numeric_limits<double>::max();
+			for (int i = 0; i < iterations; ++i)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				func();
+				duration = std::min(duration, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			std::cout << name << ": " << duration << " ms, "
+					  << data.size() / duration / 1000 << " MB/s, "
+					  << (memory::peak() - before) / 1024 << " KB peak memory\n";
+			return duration;
+		};
+
+		const auto withPositions = bench("parse", [&] { lac::parser::parseBlock(data); });
+		const auto withoutPositions = bench("parse without positions", [&] { lac::parser::parseBlock(data, false); });
+		bench("validate", [&] { lac::parser::validateBlock(data); });
+		std::cout << "positions: " << 100 * (withPositions - withoutPositions) / withPositions << "% of the parse time\n";
+	}
+
+	// Compare parsing a program with restoring it from the binary format
+	void benchBinary(std::string_view path, int iterations)
+	{
+		const auto data = loadFile(path);
+		if (data.empty())
+			return;
+
+		auto time = [iterations](auto func) {
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; ++i)
+				func();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+		};
+
+		const auto parseTime = time([&] { lac::parser::parseBlock(data); });
+
+		const auto ret = lac::parser::parseBlock(data);
+		std::string buffer;
+		const auto writeTime = time([&] {
+			buffer.clear();
+			lac::writeBinary(buffer, ret.block, ret.positions.elements());
+		});
+		const auto readTime = time([&] { lac::readBinary(buffer); });
+
+		std::cout << "parse: " << parseTime << " ms\n"
+				  << "write: " << writeTime << " ms, " << buffer.size() / 1024 << " KB\n"
+				  << "read: " << readTime << " ms\n";
+	}
 } // namespace
 
 int main(int argc, char** argv)
@@ -91,6 +205,27 @@ int main(int argc, char** argv)
 			printAst(argv[++i]);
 			return 0;
 		}
+		else if (cmd == "bench_json")
+		{
+			const auto path = argv[++i];
+			const auto iterations = i + 1 < argc ? std::atoi(argv[++i]) : 10;
+			benchJson(path, std::max(iterations, 1));
+			return 0;
+		}
+		else if (cmd == "bench_parse")
+		{
+			const auto path = argv[++i];
+			const auto iterations = i + 1 < argc ? std::atoi(argv[++i]) : 10;
+			benchParse(path, std::max(iterations, 1));
+			return 0;
+		}
+		else if (cmd == "bench_binary")
+		{
+			const auto path = argv[++i];
+			const auto iterations = i + 1 < argc ? std::atoi(argv[++i]) : 10;
+			benchBinary(path, std::max(iterations, 1));
+			return 0;
+		}
 	}
 
 	doctest::Context context;
@@ -0,0 +1,86 @@
+#include "memory_usage.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> currentUsage = 0;
+	std::atomic<size_t> peakUsage = 0;
+
+	// The size of each allocation is stored before the returned memory
+	constexpr size_t headerSize = alignof(std::max_align_t);
+
+	void* allocate(size_t size)
+	{
+		auto ptr = static_cast<char*>(std::malloc(size + headerSize));
+		if (!ptr)
+			throw std::bad_alloc{};
+
+		*reinterpret_cast<size_t*>(ptr) = size;
+		const auto usage = currentUsage += size;
+		auto peak = peakUsage.load();
+		while (usage > peak && !peakUsage.compare_exchange_weak(peak, usage))
+			;
+		return ptr + headerSize;
+	}
+
+	void deallocate(void* p)
+	{
+		if (!p)
+			return;
+
+		auto ptr = static_cast<char*>(p) - headerSize;
+		currentUsage -= *reinterpret_cast<size_t*>(ptr);
+		std::free(ptr);
+	}
+} // namespace
+
+namespace memory
+{
+	size_t current()
+	{
+		return currentUsage;
+	}
+
+	size_t peak()
+	{
+		return peakUsage;
+	}
+
+	void resetPeak()
+	{
+		peakUsage = currentUsage.load();
+	}
+} // namespace memory
+
+void* operator new(size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	deallocate(ptr);
+}
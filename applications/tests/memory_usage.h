@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts the memory allocated with the global operator new of this executable.
+// Allocations made inside a shared library using its own allocator are not counted.
+namespace memory
+{
+	size_t current();
+	size_t peak();
+	void resetPeak(); // The peak becomes the current usage
+} // namespace memory
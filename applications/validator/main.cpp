@@ -0,0 +1,302 @@
+#include "work_stealing_pool.h"
+
+#include <lac/analysis/analyze_block.h>
+#include <lac/analysis/diagnostics.h>
+#include <lac/analysis/references.h>
+#include <lac/analysis/user_defined.h>
+#include <lac/analysis/workspace_index.h>
+#include <lac/parser/parser.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	struct Options
+	{
+		size_t nbThreads = 0;
+		bool analyze = false;
+		bool symbols = false;
+		bool warnings = false;
+		bool quiet = false;
+		std::string userDefinedPath;
+		std::string find;
+		std::vector<fs::path> paths;
+	};
+
+	struct FileResult
+	{
+		bool loaded = false;
+		bool valid = false;
+		size_t size = 0;
+		double duration = 0; // In milliseconds
+		lac::parser::Diagnostics diagnostics;
+		std::vector<std::string> diagnosticPositions; // "line:column" of each diagnostic
+		std::vector<std::string> symbols;
+		std::vector<std::string> warnings; // "line:column: warning: message" of the semantic diagnostics
+		lac::an::WorkspaceSymbols globalSymbols; // For --symbols and --find
+	};
+
+	void printUsage()
+	{
+		std::cout << "Usage: validator [options] <file or directory>...\n"
+				  << "Check the syntax of Lua files, the directories are searched recursively for .lua files.\n\n"
+				  << "Options:\n"
+				  << "  --threads <n>          Number of threads (default: one per core)\n"
+				  << "  --analyze              Also analyze the valid files\n"
+				  << "  --symbols              Print the global symbols of each file (implies --analyze)\n"
+				  << "  --warnings             Print the semantic errors of each file, like undefined variables (implies --analyze)\n"
+				  << "  --find <name>          Search the global symbols of all the files by partial name (implies --analyze)\n"
+				  << "  --user-defined <file>  Load the user-defined types and variables from a json file\n"
+				  << "  --quiet                Only print the errors and the summary\n";
+	}
+
+	bool parseArguments(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--threads" && hasValue)
+				options.nbThreads = std::strtoul(argv[++i], nullptr, 10);
+			else if (arg == "--analyze")
+				options.analyze = true;
+			else if (arg == "--symbols")
+				options.analyze = options.symbols = true;
+			else if (arg == "--warnings")
+				options.analyze = options.warnings = true;
+			else if (arg == "--find" && hasValue)
+			{
+				options.find = argv[++i];
+				options.analyze = true;
+			}
+			else if (arg == "--user-defined" && hasValue)
+				options.userDefinedPath = argv[++i];
+			else if (arg == "--quiet")
+				options.quiet = true;
+			else if (arg.size() > 1 && arg[0] == '-')
+				return false;
+			else
+				options.paths.emplace_back(arg);
+		}
+
+		return !options.paths.empty();
+	}
+
+	// Sorted so that the output does not depend on the order of the file system
+	std::vector<fs::path> listFiles(const std::vector<fs::path>& paths)
+	{
+		std::vector<fs::path> files;
+		for (const auto& path : paths)
+		{
+			std::error_code ec;
+			if (fs::is_directory(path, ec))
+			{
+				for (const auto& entry : fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied, ec))
+				{
+					if (entry.is_regular_file(ec) && entry.path().extension() == ".lua")
+						files.push_back(entry.path());
+				}
+			}
+			else
+				files.push_back(path);
+		}
+
+		std::sort(files.begin(), files.end());
+		files.erase(std::unique(files.begin(), files.end()), files.end());
+		return files;
+	}
+
+	bool loadFile(const fs::path& path, std::string& data)
+	{
+		std::ifstream in(path, std::ios_base::binary);
+		if (!in)
+			return false;
+
+		in.seekg(0, std::ios_base::end);
+		data.resize(static_cast<size_t>(in.tellg()));
+		in.seekg(0, std::ios_base::beg);
+		in.read(data.data(), data.size());
+		return true;
+	}
+
+	std::string linePosition(std::string_view data, size_t offset)
+	{
+		offset = std::min(offset, data.size());
+		const auto text = data.substr(0, offset);
+		const auto line = std::count(text.begin(), text.end(), '\n') + 1;
+		const auto lineStart = text.find_last_of('\n');
+		const auto column = lineStart == std::string_view::npos ? offset + 1 : offset - lineStart;
+		return std::to_string(line) + ":" + std::to_string(column);
+	}
+
+	FileResult processFile(const fs::path& path, const Options& options, lac::an::UserDefined* userDefined)
+	{
+		FileResult result;
+		const auto start = std::chrono::steady_clock::now();
+
+		std::string data;
+		result.loaded = loadFile(path, data);
+		if (result.loaded)
+		{
+			result.size = data.size();
+
+			// The validation is faster than the parser, we only create the AST if it is needed
+			auto validation = lac::parser::validateBlock(data);
+			result.valid = validation.valid;
+			result.diagnostics = std::move(validation.diagnostics);
+			for (const auto& diagnostic : result.diagnostics)
+				result.diagnosticPositions.push_back(linePosition(data, diagnostic.offset));
+
+			if (result.valid && options.analyze)
+			{
+				const auto needReferences = options.warnings || options.symbols || !options.find.empty();
+				const auto ret = lac::parser::parseBlock(data, needReferences); // The references need the positions of the blocks
+				if (!ret.parsed)
+				{
+					// Do not analyse a partial block
+					auto diagnostic = ret.diagnostics.empty() ? lac::parser::createDiagnostic(data, ret.lastParsedPosition) : ret.diagnostics.front();
+					diagnostic.message += " (found by the parser, not by the validation)";
+					result.valid = false;
+					result.diagnosticPositions = {linePosition(data, diagnostic.offset)};
+					result.diagnostics = {std::move(diagnostic)};
+				}
+				else
+				{
+					lac::an::Scope scope{ret.block};
+					if (userDefined)
+						scope.setUserDefined(userDefined);
+					lac::an::analyseBlock(scope, ret.block);
+
+					if (needReferences)
+					{
+						const lac::an::ReferenceIndex references{scope, data};
+						if (options.warnings)
+						{
+							lac::an::DiagnosticsEngine engine;
+							for (const auto& diagnostic : engine.update(scope, data, references))
+								result.warnings.push_back(linePosition(data, diagnostic.begin) + ": warning: " + diagnostic.message);
+						}
+						if (options.symbols || !options.find.empty())
+							result.globalSymbols = lac::an::getGlobalSymbols(scope, &references);
+					}
+
+					if (options.symbols)
+					{
+						for (const auto& symbol : result.globalSymbols)
+							result.symbols.push_back(symbol.name + ": " + lac::an::TypeInfo{symbol.type}.typeName());
+					}
+				}
+			}
+		}
+
+		result.duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+} // namespace
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseArguments(argc, argv, options))
+	{
+		printUsage();
+		return 2;
+	}
+
+	lac::an::UserDefined userDefined;
+	bool hasUserDefined = false;
+	if (!options.userDefinedPath.empty())
+	{
+#ifdef WITH_NLOHMANN_JSON
+		try
+		{
+			if (!userDefined.addFromJsonFile(options.userDefinedPath))
+			{
+				std::cerr << "Cannot open " << options.userDefinedPath << "\n";
+				return 2;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Invalid user-defined file " << options.userDefinedPath << ": " << e.what() << "\n";
+			return 2;
+		}
+		hasUserDefined = true;
+#else
+		std::cerr << "json library not available, --user-defined is ignored\n";
+#endif
+	}
+
+	const auto files = listFiles(options.paths);
+	std::vector<FileResult> results(files.size());
+
+	const auto start = std::chrono::steady_clock::now();
+	validator::parallelFor(files.size(), options.nbThreads, [&](size_t index) {
+		results[index] = processFile(files[index], options, hasUserDefined ? &userDefined : nullptr);
+	});
+	const auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	size_t nbErrors = 0, totalSize = 0;
+	double totalFileDuration = 0;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		const auto& file = files[i].string();
+		const auto& result = results[i];
+		totalSize += result.size;
+		totalFileDuration += result.duration;
+
+		if (!result.loaded)
+		{
+			++nbErrors;
+			std::cout << file << ": error: cannot open the file\n";
+		}
+		else if (!result.valid)
+		{
+			++nbErrors;
+			for (size_t j = 0; j < result.diagnostics.size(); ++j)
+				std::cout << file << ":" << result.diagnosticPositions[j] << ": error: " << result.diagnostics[j].message << " (" << result.duration << " ms)\n";
+		}
+		else if (!options.quiet)
+			std::cout << file << ": ok (" << result.duration << " ms)\n";
+
+		for (const auto& warning : result.warnings)
+			std::cout << file << ":" << warning << "\n";
+		for (const auto& symbol : result.symbols)
+			std::cout << "  " << symbol << "\n";
+	}
+
+	if (!options.find.empty())
+	{
+		lac::an::WorkspaceIndex index;
+		for (size_t i = 0; i < files.size(); ++i)
+			index.updateFile(files[i].string(), std::move(results[i].globalSymbols));
+
+		const auto searchStart = std::chrono::steady_clock::now();
+		const auto matches = index.search(options.find);
+		const auto searchDuration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart).count();
+		for (const auto& match : matches)
+		{
+			std::string data, position;
+			if (match.symbol.position != std::string::npos && loadFile(match.file, data))
+				position = ":" + linePosition(data, match.symbol.position);
+			std::cout << match.file << position << ": " << match.symbol.name << " (" << lac::an::TypeInfo{match.symbol.type}.typeName() << ")\n";
+		}
+		std::cout << matches.size() << " symbols matching '" << options.find << "' out of " << index.size() << " (" << searchDuration << " ms)\n";
+	}
+
+	const auto megabytes = totalSize / 1e6;
+	std::cout << files.size() << " files, " << nbErrors << " with errors, "
+			  << megabytes << " MB in " << duration << " ms ("
+			  << (duration > 0 ? megabytes / duration * 1000 : 0) << " MB/s, "
+			  << totalFileDuration << " ms cumulated over the threads)\n";
+
+	return nbErrors ? 1 : 0;
+}
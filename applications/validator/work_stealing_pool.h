@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace validator
+{
+	// Calls func(index) for each index in [0, count) using multiple threads.
+	// Each thread starts with a contiguous range of indices, and when it has nothing left to do it steals from the end of the others' ranges.
+	template <class Func>
+	void parallelFor(size_t count, size_t nbThreads, Func func)
+	{
+		if (!nbThreads)
+			nbThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		nbThreads = std::min(nbThreads, count);
+		if (nbThreads <= 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+				func(i);
+			return;
+		}
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<size_t> indices;
+		};
+		std::vector<Queue> queues(nbThreads);
+		for (size_t i = 0; i < nbThreads; ++i)
+		{
+			const auto begin = i * count / nbThreads, end = (i + 1) * count / nbThreads;
+			for (auto j = begin; j < end; ++j)
+				queues[i].indices.push_back(j);
+		}
+
+		auto popOwn = [&](Queue& queue, size_t& index) {
+			std::lock_guard lock{queue.mutex};
+			if (queue.indices.empty())
+				return false;
+			index = queue.indices.front();
+			queue.indices.pop_front();
+			return true;
+		};
+
+		auto steal = [&](Queue& queue, size_t& index) {
+			std::lock_guard lock{queue.mutex};
+			if (queue.indices.empty())
+				return false;
+			index = queue.indices.back();
+			queue.indices.pop_back();
+			return true;
+		};
+
+		auto worker = [&](size_t id) {
+			size_t index = 0;
+			for (;;)
+			{
+				if (popOwn(queues[id], index))
+				{
+					func(index);
+					continue;
+				}
+
+				// No task is ever added, so we can stop when all the queues are empty
+				bool found = false;
+				for (size_t i = 1; i < nbThreads && !found; ++i)
+					found = steal(queues[(id + i) % nbThreads], index);
+				if (!found)
+					return;
+				func(index);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < nbThreads; ++i)
+			threads.emplace_back(worker, i);
+		worker(0);
+		for (auto& thread : threads)
+			thread.join();
+	}
+} // namespace validator
@@ -0,0 +1,100 @@
+#include <lac/editor/AnalysisScheduler.h>
+
+#include <QTimer>
+
+#include <algorithm>
+
+namespace
+{
+	constexpr qint64 maxTypingInterval = 2000; // Longer pauses are not taken into account for the typing speed
+} // namespace
+
+namespace lac::editor
+{
+	AnalysisScheduler::AnalysisScheduler(AnalyzeFunc func, QObject* parent)
+		: QObject(parent)
+		, m_analyzeFunc(std::move(func))
+		, m_timer(new QTimer(this))
+	{
+		m_timer->setSingleShot(true);
+		connect(m_timer, &QTimer::timeout, this, [this] { analyze(); });
+		m_clock.start();
+	}
+
+	void AnalysisScheduler::setDelays(int minDelay, int maxDelay)
+	{
+		m_minDelay = minDelay;
+		m_maxDelay = std::max(minDelay, maxDelay);
+	}
+
+	void AnalysisScheduler::addEdit(int position)
+	{
+		const auto now = m_clock.elapsed();
+		if (m_lastEditTime >= 0)
+		{
+			const auto interval = now - m_lastEditTime;
+			if (interval < maxTypingInterval)
+				m_typingInterval = m_typingInterval ? 0.7 * m_typingInterval + 0.3 * interval : interval;
+		}
+		m_lastEditTime = now;
+
+		if (!m_metrics.queueDepth)
+		{
+			m_firstPendingTime = now;
+			m_pendingBegin = position;
+		}
+		else
+			m_pendingBegin = std::min(m_pendingBegin, position);
+		++m_metrics.queueDepth;
+
+		m_timer->start(delay()); // Restarts the timer if it was already active
+	}
+
+	bool AnalysisScheduler::hasPendingEdits() const
+	{
+		return m_metrics.queueDepth != 0;
+	}
+
+	bool AnalysisScheduler::isPendingBefore(int position) const
+	{
+		// Only the text before the first pending edit is at the same offsets as during the last analysis
+		return hasPendingEdits() && position >= m_pendingBegin;
+	}
+
+	void AnalysisScheduler::flush()
+	{
+		if (hasPendingEdits())
+			analyze();
+	}
+
+	AnalysisMetrics AnalysisScheduler::metrics() const
+	{
+		auto metrics = m_metrics;
+		if (hasPendingEdits())
+			metrics.staleness = m_clock.elapsed() - m_firstPendingTime;
+		return metrics;
+	}
+
+	void AnalysisScheduler::analyze()
+	{
+		m_timer->stop();
+		m_metrics.queueDepth = 0;
+
+		QElapsedTimer timer;
+		timer.start();
+		if (m_analyzeFunc)
+			m_analyzeFunc();
+		const auto duration = timer.elapsed();
+
+		m_metrics.lastAnalysisTime = duration;
+		m_metrics.averageAnalysisTime = (m_metrics.averageAnalysisTime * m_metrics.nbAnalyses + duration) / (m_metrics.nbAnalyses + 1);
+		++m_metrics.nbAnalyses;
+	}
+
+	int AnalysisScheduler::delay() const
+	{
+		// Wait a bit more than the usual time between two key presses, so that we do not analyze in the middle of a word
+		const auto delay = static_cast<int>(2 * m_typingInterval);
+		return std::clamp(delay, m_minDelay, m_maxDelay);
+	}
+} // namespace lac::editor
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <lac/editor_api.h>
+
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <functional>
+
+class QTimer;
+
+namespace lac::editor
+{
+	struct AnalysisMetrics
+	{
+		int queueDepth = 0;           // Number of edits waiting for the next analysis
+		qint64 lastAnalysisTime = 0;  // Duration of the last analysis, in milliseconds
+		double averageAnalysisTime = 0;
+		qint64 staleness = 0;         // Age of the oldest edit not yet analyzed, in milliseconds
+		int nbAnalyses = 0;
+	};
+
+	// Run the analysis once the user pauses typing, instead of polling the document
+	class EDITOR_API AnalysisScheduler : public QObject
+	{
+	public:
+		using AnalyzeFunc = std::function<void()>;
+
+		AnalysisScheduler(AnalyzeFunc func, QObject* parent = nullptr);
+
+		void setDelays(int minDelay, int maxDelay); // Bounds of the debounce delay, in milliseconds
+
+		// Position of a change of the document, the edits are coalesced until the next analysis
+		void addEdit(int position);
+
+		bool hasPendingEdits() const;
+		bool isPendingBefore(int position) const; // If an edit not yet analyzed moved this position, the last analysis has other offsets
+
+		void flush(); // Run the analysis now if there are pending edits
+		AnalysisMetrics metrics() const;
+
+	private:
+		void analyze();
+		int delay() const; // Depends on the typing speed
+
+		AnalyzeFunc m_analyzeFunc;
+		QTimer* m_timer = nullptr;
+		QElapsedTimer m_clock;
+		qint64 m_lastEditTime = -1, m_firstPendingTime = -1;
+		double m_typingInterval = 0; // Moving average of the time between two edits
+		int m_minDelay = 150, m_maxDelay = 1000;
+		int m_pendingBegin = 0; // First position modified since the last analysis
+		AnalysisMetrics m_metrics;
+	};
+} // namespace lac::editor
@@ -1,5 +1,24 @@
 #include <lac/editor/EditorHighlighter.h>
 
+#include <QTextBlock>
+#include <QTextBlockUserData>
+#include <QTextDocument>
+
+namespace
+{
+	// Remember which parse was used to highlight a block
+	class ElementsBlockData : public QTextBlockUserData
+	{
+	public:
+		ElementsBlockData(int generation)
+			: generation(generation)
+		{
+		}
+
+		int generation = 0;
+	};
+} // namespace
+
 namespace lac::editor
 {
 	EditorHighlighter::EditorHighlighter(QTextDocument* document)
@@ -9,6 +28,8 @@ namespace lac::editor
 
 	void EditorHighlighter::useLuaRules()
 	{
+		reset(HighlightMode::rules);
+
 		auto addRule = [this](QString regex, QColor forecolor, bool isGlobal = true) {
 			HighlightRule rule;
 			rule.regex = QRegularExpression{regex};
@@ -59,9 +80,155 @@ namespace lac::editor
 
 		// Singleline comments
 		addRule("--[^\\[].*$", "#57a64a", false);
+
+		rehighlight();
+	}
+
+	void EditorHighlighter::useLuaLexer()
+	{
+		reset(HighlightMode::lexer);
+		setLuaFormats();
+
+		// Metatables methods
+		for (const auto name : {"__add", "__sub", "__mul", "__div", "__mod", "__pow", "__unm", "__idiv", "__band", "__bor", "__bxor",
+								"__bnot", "__shl", "__shr", "__concat", "__len", "__eq", "__lt", "__le", "__index", "__newindex", "__call"})
+			specialNames.insert(name);
+
+		rehighlight();
+	}
+
+	void EditorHighlighter::useLuaElements(ElementsFunc func)
+	{
+		reset(HighlightMode::elements);
+		m_elementsFunc = std::move(func);
+		setLuaFormats();
+
+		rehighlight();
+	}
+
+	void EditorHighlighter::reset(HighlightMode mode)
+	{
+		m_mode = mode;
+		m_elementsFunc = {};
+		rules.clear();
+		elementFormats.clear();
+		specialNames.clear();
+
+		// The states of the lexer and the generations of the elements mean nothing in another mode
+		if (const auto doc = document())
+		{
+			for (auto block = doc->begin(); block.isValid(); block = block.next())
+			{
+				block.setUserState(-1);
+				block.setUserData(nullptr);
+			}
+		}
+	}
+
+	void EditorHighlighter::setLuaFormats()
+	{
+		auto addFormat = [this](ast::ElementType type, QColor forecolor) {
+			QTextCharFormat format;
+			format.setForeground(forecolor);
+			elementFormats[type] = format;
+		};
+
+		// Same colors as the Lua rules
+		addFormat(ast::ElementType::numeral, "#c3e88d");
+		addFormat(ast::ElementType::keyword, "#569cd6");
+		addFormat(ast::ElementType::literal_string, "#d69d85");
+		addFormat(ast::ElementType::comment, "#57a64a");
+	}
+
+	HighlightMode EditorHighlighter::mode() const
+	{
+		return m_mode;
+	}
+
+	void EditorHighlighter::elementsUpdated()
+	{
+		++m_elementsGeneration;
+	}
+
+	void EditorHighlighter::rehighlightIfOutdated(const QTextBlock& block)
+	{
+		if (m_mode != HighlightMode::elements)
+			return;
+
+		const auto data = static_cast<ElementsBlockData*>(block.userData());
+		if (!data || data->generation != m_elementsGeneration)
+			rehighlightBlock(block);
 	}
 
 	void EditorHighlighter::highlightBlock(const QString& text)
+	{
+		switch (m_mode)
+		{
+		case HighlightMode::rules:
+			highlightRules(text);
+			break;
+		case HighlightMode::lexer:
+			highlightLexer(text);
+			break;
+		case HighlightMode::elements:
+			highlightElements(text);
+			break;
+		}
+	}
+
+	void EditorHighlighter::highlightLexer(const QString& text)
+	{
+		// Lua code is ASCII outside of strings and comments, and Latin-1 keeps one byte per character
+		const auto line = text.toLatin1();
+
+		m_tokens.clear();
+		const auto state = parser::lexLine({line.constData(), static_cast<size_t>(line.size())},
+										   parser::LexerState::fromInt(previousBlockState()),
+										   m_tokens);
+
+		const auto keywordIt = elementFormats.find(ast::ElementType::keyword);
+		for (const auto& token : m_tokens)
+		{
+			const auto start = static_cast<int>(token.begin);
+			const auto length = static_cast<int>(token.end - token.begin);
+			if (token.type == ast::ElementType::variable)
+			{
+				if (keywordIt != elementFormats.end() && specialNames.count(text.mid(start, length)))
+					setFormat(start, length, keywordIt->second);
+				continue;
+			}
+
+			const auto it = elementFormats.find(token.type);
+			if (it != elementFormats.end())
+				setFormat(start, length, it->second);
+		}
+
+		// Qt continues with the next line only if its previous state was different
+		setCurrentBlockState(state.toInt());
+	}
+
+	void EditorHighlighter::highlightElements(const QString& text)
+	{
+		// The block state is not used, so that Qt does not continue on the following blocks
+		setCurrentBlockUserData(new ElementsBlockData{m_elementsGeneration});
+		if (!m_elementsFunc)
+			return;
+
+		const auto blockStart = static_cast<size_t>(currentBlock().position());
+		const auto blockEnd = blockStart + text.size();
+		for (const auto& elt : m_elementsFunc(blockStart, blockEnd))
+		{
+			const auto it = elementFormats.find(elt.type);
+			if (it == elementFormats.end())
+				continue;
+
+			const auto start = std::max(elt.begin, blockStart) - blockStart;
+			const auto end = std::min(elt.end, blockEnd) - blockStart;
+			setFormat(static_cast<int>(start), static_cast<int>(end - start), it->second);
+		}
+	}
+
+	void EditorHighlighter::highlightRules(const QString& text)
 	{
 		setCurrentBlockState(-1);
 
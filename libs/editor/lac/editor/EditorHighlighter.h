@@ -1,11 +1,17 @@
 #pragma once
 
 #include <lac/editor_api.h>
+#include <lac/parser/lexer.h>
+#include <lac/parser/positions.h>
 
 #include <QBrush>
 #include <QRegularExpression>
 #include <QSyntaxHighlighter>
+#include <QTextCharFormat>
 
+#include <functional>
+#include <map>
+#include <set>
 #include <vector>
 
 class QTextDocument;
@@ -19,17 +25,49 @@ namespace lac::editor
 		bool isGlobal = true;
 	};
 
+	enum class HighlightMode
+	{
+		rules,    // Regular expressions applied on each line
+		lexer,    // Lua lexer, the state at the end of each line is stored in the block
+		elements  // Elements of the last parse, only applied on the visible lines
+	};
+
 	class EDITOR_API EditorHighlighter : public QSyntaxHighlighter
 	{
 		Q_OBJECT
 	public:
+		using ElementsFunc = std::function<pos::Elements(size_t begin, size_t end)>; // Positions in the document
+
 		EditorHighlighter(QTextDocument* document);
 
 		void useLuaRules();
+		void useLuaLexer();
+		void useLuaElements(ElementsFunc func); // Use the parser elements instead of the rules
+
+		HighlightMode mode() const;
+
+		// Must be called after each parse, the blocks are then highlighted again only when rehighlightIfOutdated is called on them
+		void elementsUpdated();
+		void rehighlightIfOutdated(const QTextBlock& block);
 
 		std::vector<HighlightRule> rules;
+		std::map<ast::ElementType, QTextCharFormat> elementFormats;
+		std::set<QString> specialNames; // Names using the keyword format in the lexer mode
 
 	protected:
 		void highlightBlock(const QString& text) override;
+
+		void highlightRules(const QString& text);
+		void highlightLexer(const QString& text);
+		void highlightElements(const QString& text);
+
+	private:
+		void reset(HighlightMode mode); // Remove the rules, the formats and the states of the blocks of the previous mode
+		void setLuaFormats();
+
+		HighlightMode m_mode = HighlightMode::rules;
+		ElementsFunc m_elementsFunc;
+		int m_elementsGeneration = 0;
+		parser::Tokens m_tokens;
 	};
 } // namespace lac::editor
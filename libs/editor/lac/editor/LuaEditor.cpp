@@ -8,24 +8,13 @@
 #include <QCompleter>
 #include <QScrollBar>
 #include <QTextBlock>
-#include <QTimer>
+#include <QTextDocument>
 #include <QToolTip>
 
 #include <cctype>
 
 namespace
 {
-	void removeNonASCII(std::string& str)
-	{
-		// Remove utf-8 characters as we use ASCII for now
-		// TODO: support UTF-8
-		for (auto& c : str)
-		{
-			if (c < 0)
-				c = ' ';
-		}
-	}
-
 	bool isName(int ch)
 	{
 		return std::isalnum(ch) || ch == '_';
@@ -38,7 +27,7 @@ namespace lac::editor
 		: QPlainTextEdit(parent)
 		, m_completer(new QCompleter)
 		, m_completionModel(new CompletionModel)
-		, m_highlighter(new EditorHighlighter(document()))
+		, m_scheduler(new AnalysisScheduler([this] { analyzeProgram(); }, this))
 	{
 		m_completer->setWidget(this);
 		m_completer->setCompletionMode(QCompleter::PopupCompletion);
@@ -55,16 +44,23 @@ namespace lac::editor
 
 		setDesign({});
 
-		// This is an ugly way to test the completion
-		auto timer = new QTimer(this);
-		connect(timer, &QTimer::timeout, this, [this] { updateProgram(); });
-		timer->start(1000);
-
-		connect(this, &QPlainTextEdit::textChanged, this, [this] {
-			m_textChanged = true;
+		// The program is analyzed only after it has been modified
+		m_buffer.reset(document());
+		connect(document(), &QTextDocument::contentsChange, this, [this](int position, int charsRemoved, int charsAdded) {
+			m_buffer.applyChange(document(), position, charsRemoved, charsAdded);
+			m_scheduler->addEdit(position);
 		});
 
+		// After the buffer, so that the slot of the highlighter sees the new lines when converting the positions
+		m_highlighter = new EditorHighlighter(document());
+
 		connect(m_completer, QOverload<const QString&>::of(&QCompleter::activated), this, &LuaEditor::completeWord);
+
+		// Newly visible lines may have been highlighted with an older parse
+		connect(this, &QPlainTextEdit::updateRequest, this, [this](const QRect&, int dy) {
+			if (dy)
+				highlightVisibleBlocks();
+		});
 	}
 
 	void LuaEditor::setDesign(const EditorDesign& design)
@@ -142,6 +138,23 @@ namespace lac::editor
 		return m_highlighter;
 	}
 
+	void LuaEditor::useElementsHighlighting()
+	{
+		// The elements use offsets in the UTF-8 buffer, the highlighter uses positions in the document
+		m_highlighter->useLuaElements([this](size_t begin, size_t end) {
+			auto elements = m_programCompletion.getElementsInRange(m_buffer.toOffset(static_cast<int>(begin)),
+																   m_buffer.toOffset(static_cast<int>(end)));
+			for (auto& elt : elements)
+			{
+				elt.begin = m_buffer.toPosition(elt.begin);
+				elt.end = m_buffer.toPosition(elt.end);
+			}
+			return elements;
+		});
+		m_highlighter->elementsUpdated();
+		highlightVisibleBlocks();
+	}
+
 	void LuaEditor::setTooltipFunc(TooltipFunc func)
 	{
 		m_tooltipFunc = func;
@@ -149,46 +162,31 @@ namespace lac::editor
 
 	an::TypeInfo LuaEditor::getTypeAtCursor()
 	{
-		auto text = document()->toPlainText().toStdString();
-		const auto editPos = std::max(0, textCursor().position() - 1);
-		removeNonASCII(text);
-
-		if (m_textChanged)
-		{
-			m_programCompletion.updateProgram(text, editPos);
-			m_textChanged = false;
-		}
+		if (m_scheduler->isPendingBefore(textCursor().position()))
+			m_scheduler->flush();
 
+		const auto editPos = editOffset();
+		const auto text = m_buffer.view();
 		return m_programCompletion.getTypeAtPos(text, editPos);
 	}
 
 	std::vector<std::string> LuaEditor::getTypeHierarchyAtCursor()
 	{
-		auto text = document()->toPlainText().toStdString();
-		const auto editPos = std::max(0, textCursor().position() - 1);
-		removeNonASCII(text);
-
-		if (m_textChanged)
-		{
-			m_programCompletion.updateProgram(text, editPos);
-			m_textChanged = false;
-		}
+		if (m_scheduler->isPendingBefore(textCursor().position()))
+			m_scheduler->flush();
 
+		const auto editPos = editOffset();
+		const auto text = m_buffer.view();
 		return m_programCompletion.getTypeHierarchyAtPos(text, editPos);
 	}
 
 	std::string LuaEditor::getVariableNameAtCursor()
 	{
-		auto text = document()->toPlainText().toStdString();
-		const auto editPos = std::max(0, textCursor().position() - 1);
-		removeNonASCII(text);
-
-		if (m_textChanged)
-		{
-			m_programCompletion.updateProgram(text, editPos);
-			m_textChanged = false;
-		}
+		if (m_scheduler->isPendingBefore(textCursor().position()))
+			m_scheduler->flush();
 
+		const auto editPos = editOffset();
+		const auto text = m_buffer.view();
 		return m_programCompletion.getVariableNameAtPos(text, editPos);
 	}
 
@@ -197,11 +195,10 @@ namespace lac::editor
 		if (evt->type() == QEvent::ToolTip)
 		{
 			QHelpEvent* helpEvent = static_cast<QHelpEvent*>(evt);
-			const auto pos = cursorForPosition(helpEvent->pos()).position();
-			auto text = document()->toPlainText().toStdString();
-			removeNonASCII(text);
+			const auto pos = m_buffer.toOffset(cursorForPosition(helpEvent->pos()).position());
+			const auto text = m_buffer.view();
 
-			if (!isName(text[pos]))
+			if (pos >= text.size() || !isName(static_cast<unsigned char>(text[pos])))
 			{
 				QToolTip::hideText();
 				return true;
@@ -487,7 +484,6 @@ namespace lac::editor
 			if (refreshed) // Ensure we only do it once in this function
 				return;
 
-			m_textChanged = true;
 			updateProgram(CompletionType::Variable);
 			m_completer->setCompletionPrefix(prefix);
 			refreshed = true;
@@ -540,7 +536,6 @@ namespace lac::editor
 
 		if (!m_completer->popup()->isVisible() && askArgumentPopup(event))
 		{
-			m_textChanged = true;
 			updateProgram(CompletionType::Argument);
 			m_completer->setCompletionPrefix(prefix);
 
@@ -609,18 +604,13 @@ namespace lac::editor
 
 	void LuaEditor::updateProgram(CompletionType type)
 	{
-		if (!m_textChanged)
-			return;
-
-		auto text = document()->toPlainText().toStdString();
-		removeNonASCII(text);
-
-		const auto pos = textCursor().position() - 1;
-		m_programCompletion.updateProgram(text, pos);
-		m_textChanged = false;
+		m_scheduler->flush();
 
 		if (!m_completer->popup()->isVisible())
 		{
+			const auto text = m_buffer.view();
+			const auto pos = editOffset();
+
 			lac::an::ElementsMap elements;
 			if (type == CompletionType::Variable)
 				elements = m_programCompletion.getVariableCompletionList(text, pos);
@@ -634,11 +624,51 @@ namespace lac::editor
 		}
 	}
 
+	void LuaEditor::analyzeProgram()
+	{
+		m_programCompletion.updateProgram(m_buffer.view(), editOffset());
+
+		if (m_highlighter->mode() == HighlightMode::elements)
+		{
+			m_highlighter->elementsUpdated();
+			highlightVisibleBlocks();
+		}
+	}
+
+	size_t LuaEditor::editOffset() const
+	{
+		const auto offset = m_buffer.toOffset(textCursor().position());
+		return offset ? offset - 1 : 0;
+	}
+
+	void LuaEditor::highlightVisibleBlocks()
+	{
+		if (m_highlighter->mode() != HighlightMode::elements)
+			return;
+
+		const auto bottom = viewport()->rect().bottom();
+		for (auto block = firstVisibleBlock(); block.isValid(); block = block.next())
+		{
+			if (blockBoundingGeometry(block).translated(contentOffset()).top() > bottom)
+				break;
+
+			m_highlighter->rehighlightIfOutdated(block);
+		}
+	}
+
+	AnalysisScheduler* LuaEditor::analysisScheduler()
+	{
+		return m_scheduler;
+	}
+
+	AnalysisMetrics LuaEditor::analysisMetrics() const
+	{
+		return m_scheduler->metrics();
+	}
+
 	parser::ParseBlockResults LuaEditor::compileProgram()
 	{
-		auto text = document()->toPlainText().toStdString();
-		removeNonASCII(text);
-		return lac::parser::parseBlock(text);
+		return lac::parser::parseBlock(m_buffer.view());
 	}
 
 } // namespace lac::editor
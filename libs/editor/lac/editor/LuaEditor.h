@@ -1,6 +1,8 @@
 #pragma once
 
 #include <lac/editor_api.h>
+#include <lac/editor/AnalysisScheduler.h>
+#include <lac/editor/TextBuffer.h>
 #include <lac/completion/completion.h>
 #include <lac/parser/parser.h>
 
@@ -45,6 +47,7 @@ namespace lac::editor
 		void setUserDefined(lac::an::UserDefined userDefined); // Setup custom types & functions
 
 		EditorHighlighter* highlighter();
+		void useElementsHighlighting(); // Color the visible lines using the result of the parser
 
 		void setTooltipFunc(TooltipFunc func);
 
@@ -54,6 +57,9 @@ namespace lac::editor
 
 		parser::ParseBlockResults compileProgram();
 
+		AnalysisScheduler* analysisScheduler();
+		AnalysisMetrics analysisMetrics() const;
+
 	protected:
 		bool event(QEvent* evt) override;
 		void keyPressEvent(QKeyEvent* event) override;
@@ -68,7 +74,10 @@ namespace lac::editor
 			Variable,
 			Argument
 		};
-		void updateProgram(CompletionType type = CompletionType::None);
+		void updateProgram(CompletionType type = CompletionType::None); // Analyze the pending edits and update the completion list
+		void analyzeProgram();
+		void highlightVisibleBlocks(); // When the highlighter uses the parser elements
+		size_t editOffset() const;     // Offset in the text buffer of the character before the cursor
 
 	private:
 		QCompleter* m_completer = nullptr;
@@ -76,7 +85,8 @@ namespace lac::editor
 		lac::comp::Completion m_programCompletion;
 
 		EditorHighlighter* m_highlighter = nullptr;
-		bool m_textChanged = true;
+		AnalysisScheduler* m_scheduler = nullptr;
+		TextBuffer m_buffer;
 
 		TooltipFunc m_tooltipFunc;
 	};
@@ -0,0 +1,66 @@
+#include <lac/editor/TextBuffer.h>
+
+#include <QTextCursor>
+#include <QTextDocument>
+
+#include <algorithm>
+
+namespace
+{
+	// Same conversions as QTextDocument::toPlainText
+	std::string toPlainUtf8(QString text)
+	{
+		text.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+		text.replace(QChar::Nbsp, QLatin1Char(' '));
+		return text.toStdString();
+	}
+} // namespace
+
+namespace lac::editor
+{
+	void TextBuffer::reset(QTextDocument* document)
+	{
+		m_buffer.assign(document->toPlainText().toStdString());
+	}
+
+	void TextBuffer::applyChange(QTextDocument* document, int position, int charsRemoved, int charsAdded)
+	{
+		// Qt can include the last paragraph separator in the modification, in which case we copy everything
+		const auto oldLength = m_buffer.utf16Size();
+		const auto newLength = static_cast<size_t>(document->characterCount() - 1); // Without the last paragraph separator
+		if (position < 0
+			|| static_cast<size_t>(position + charsRemoved) > oldLength
+			|| static_cast<size_t>(position + charsAdded) > newLength
+			|| oldLength - charsRemoved + charsAdded != newLength)
+		{
+			reset(document);
+			return;
+		}
+
+		QString added;
+		if (charsAdded)
+		{
+			QTextCursor cursor{document};
+			cursor.setPosition(position);
+			cursor.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+			added = cursor.selectedText();
+		}
+
+		m_buffer.replace(position, charsRemoved, toPlainUtf8(added));
+	}
+
+	std::string_view TextBuffer::view() const
+	{
+		return m_buffer.view();
+	}
+
+	size_t TextBuffer::toOffset(int position) const
+	{
+		return m_buffer.toUtf8(static_cast<size_t>(std::max(0, position)));
+	}
+
+	int TextBuffer::toPosition(size_t offset) const
+	{
+		return static_cast<int>(m_buffer.toUtf16(offset));
+	}
+} // namespace lac::editor
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <lac/editor_api.h>
+#include <lac/helper/utf8_buffer.h>
+
+#include <string_view>
+
+class QTextDocument;
+
+namespace lac::editor
+{
+	// UTF-8 copy of the text of a document, updated with each modification so that it can be shared without any conversion.
+	// Qt positions (UTF-16) must be converted to offsets in this buffer, and back.
+	class EDITOR_API TextBuffer
+	{
+	public:
+		void reset(QTextDocument* document);
+		void applyChange(QTextDocument* document, int position, int charsRemoved, int charsAdded); // Arguments of QTextDocument::contentsChange
+
+		std::string_view view() const;
+
+		size_t toOffset(int position) const;
+		int toPosition(size_t offset) const;
+
+	private:
+		helper::Utf8Buffer m_buffer;
+	};
+} // namespace lac::editor
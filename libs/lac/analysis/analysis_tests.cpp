@@ -1,7 +1,11 @@
 #include <lac/analysis/analyze_block.h>
+#include <lac/analysis/diagnostics.h>
+#include <lac/analysis/get_type.h>
+#include <lac/analysis/references.h>
 #include <lac/analysis/scope.h>
 #include <lac/analysis/user_defined.h>
 #include <lac/parser/chunk.h>
+#include <lac/parser/parser.h>
 
 #include <lac/helper/arguments.h>
 #include <lac/helper/test_utils.h>
@@ -931,6 +935,489 @@ end
 			}
 		}
 
+		TEST_CASE("Reference index")
+		{
+			const std::string program = R"~~(
+local count = 0
+function increment(step, ...)
+	count = count + step
+	return count
+end
+local t = { count = 1, step = 2 }
+t.count = increment(t.step)
+for i, v in pairs(t) do
+	local count = i
+	print(count, v)
+end
+function t:get() return self.count end
+total, other = count, undefined
+)~~";
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+			const auto scope = analyseBlock(ret.block);
+			const ReferenceIndex index{scope, program};
+
+			auto at = [&program](std::string_view text, size_t nth = 0) {
+				auto pos = program.find(text);
+				while (nth--)
+					pos = program.find(text, pos + 1);
+				return pos;
+			};
+
+			// Local variable of the root scope, not the members nor the local of the loop
+			const auto countDef = index.getDefinitionAtPos(at("count", 3));
+			REQUIRE(countDef.has_value());
+			CHECK(countDef->begin == at("count"));
+			CHECK(countDef->end == at("count") + 5);
+			const auto countRefs = index.getReferencesAtPos(at("count"));
+			REQUIRE(countRefs.size() == 5);
+			CHECK(countRefs[1].begin == at("count", 1));
+			CHECK(countRefs[3].begin == at("count", 3));
+			CHECK(countRefs[4].begin == at("count, undefined"));
+			CHECK(index.symbolAtPos(at("count", 3))->scope == &scope);
+
+			// Declared in the loop
+			const auto innerCount = at("local count = i") + 6;
+			CHECK(index.getReferencesAtPos(innerCount).size() == 2);
+			CHECK(index.getDefinitionAtPos(at("print(count") + 6)->begin == innerCount);
+			REQUIRE(index.symbolAtPos(innerCount) != nullptr);
+			CHECK(index.symbolAtPos(innerCount)->scope == &scope.children()[1]);
+
+			// Parameters, loop variables and the implicit self parameter
+			CHECK(index.getDefinitionAtPos(at("step", 1))->begin == at("step"));
+			CHECK(index.getReferencesAtPos(at("step")).size() == 2);
+			CHECK(index.getReferencesAtPos(at("v)")).size() == 2);
+			const auto self = index.symbolAtPos(at("self"));
+			REQUIRE(self != nullptr);
+			CHECK_FALSE(self->definition.has_value());
+			CHECK(self->scope == &scope.children().back());
+
+			// Global variables are defined by their first assignment
+			const auto increment = index.symbolAtPos(at("increment", 1));
+			REQUIRE(increment != nullptr);
+			CHECK(increment->scope == &scope);
+			REQUIRE(increment->definition.has_value());
+			CHECK(increment->definition->begin == at("increment"));
+			CHECK(increment->definition->type == ast::ElementType::function);
+			CHECK(increment->uses.size() == 2);
+			CHECK(index.getDefinitionAtPos(at("other"))->begin == at("other"));
+			CHECK(index.getDefinitionAtPos(at("total"))->begin == at("total"));
+			CHECK_FALSE(index.getDefinitionAtPos(at("undefined")).has_value());
+			CHECK(index.getReferencesAtPos(at("pairs")).size() == 1);
+
+			// Not symbols
+			CHECK(index.symbolAtPos(at("step = 2")) == nullptr);
+			CHECK(index.symbolAtPos(at("get")) == nullptr);
+			CHECK(index.symbolAtPos(at("function")) == nullptr);
+			CHECK(index.symbolAtPos(0) == nullptr);
+
+			// A local variable is only visible after the end of its statement
+			const std::string shadowing = "x = 1; local x = x + 1; local f = function() return f, x end; print(x, f)";
+			const auto shadowingRet = parser::parseBlock(shadowing);
+			REQUIRE(shadowingRet.parsed);
+			const auto shadowingScope = analyseBlock(shadowingRet.block);
+			const ReferenceIndex shadowingIndex{shadowingScope, shadowing};
+			CHECK(shadowingIndex.getDefinitionAtPos(shadowing.find("x + 1"))->begin == 0);
+			CHECK(shadowingIndex.getDefinitionAtPos(shadowing.find("x end"))->begin == shadowing.find("x = x"));
+			CHECK_FALSE(shadowingIndex.getDefinitionAtPos(shadowing.find("f, x")).has_value());
+			CHECK(shadowingIndex.getDefinitionAtPos(shadowing.find("x, f"))->begin == shadowing.find("x = x"));
+			CHECK(shadowingIndex.getDefinitionAtPos(shadowing.find("f)"))->begin == shadowing.find("f ="));
+		}
+
+		TEST_CASE("Diagnostics")
+		{
+			std::string program = R"~~(
+local count = 0
+function add(a, b)
+	return a + b
+end
+function check(flag)
+	local n = #count
+	add(1, 2, 3)
+	add(unknown, 2)
+	return flag and count < "limit"
+end
+local t = { size = 2 }
+function t:grow(n) self.size = self.size + n end
+t:grow(1)
+t.grow(t, 1)
+t.size()
+print(add(count, check(true)), ...)
+)~~";
+			auto analyse = [](const std::string& text, DiagnosticsEngine& engine) {
+				const auto ret = parser::parseBlock(text);
+				REQUIRE(ret.parsed);
+				const auto scope = analyseBlock(ret.block);
+				const ReferenceIndex index{scope, text};
+				return engine.update(scope, text, index);
+			};
+
+			auto at = [&program](std::string_view text) {
+				return program.find(text);
+			};
+
+			DiagnosticsEngine engine;
+			auto diagnostics = analyse(program, engine);
+			CHECK(engine.visitedFunctions() == 3);
+			REQUIRE(diagnostics.size() == 5);
+
+			CHECK(diagnostics[0].type == DiagnosticType::invalidOperation);
+			CHECK(diagnostics[0].begin == at("#count"));
+			CHECK(diagnostics[0].end == at("#count") + 6);
+			CHECK(diagnostics[0].message == "Invalid operation '#' on number");
+
+			CHECK(diagnostics[1].type == DiagnosticType::argumentsCount);
+			CHECK(diagnostics[1].begin == at("(1, 2, 3)"));
+			CHECK(diagnostics[1].end == at("(1, 2, 3)") + 9);
+			CHECK(diagnostics[1].message == "Too many arguments for 'add': 2 expected but 3 given");
+
+			CHECK(diagnostics[2].type == DiagnosticType::undefinedVariable);
+			CHECK(diagnostics[2].begin == at("unknown"));
+			CHECK(diagnostics[2].end == at("unknown") + 7);
+			CHECK(diagnostics[2].message == "Undefined variable 'unknown'");
+
+			CHECK(diagnostics[3].type == DiagnosticType::invalidOperation);
+			CHECK(diagnostics[3].begin == at("count < "));
+			CHECK(diagnostics[3].end == at("\"limit\"") + 7);
+			CHECK(diagnostics[3].message == "Invalid operation '<' between number and string");
+
+			CHECK(diagnostics[4].type == DiagnosticType::notAFunction);
+			CHECK(diagnostics[4].begin == at("()\nprint"));
+			CHECK(diagnostics[4].message == "Cannot call 't.size', it is a number");
+
+			// Only the modified function is checked again, the other results are moved
+			program.insert(at("function check"), "\n\n");
+			program.replace(at("#count"), 6, "#{}");
+			diagnostics = analyse(program, engine);
+			CHECK(engine.visitedFunctions() == 1);
+			REQUIRE(diagnostics.size() == 4);
+			CHECK(diagnostics[0].begin == at("(1, 2, 3)"));
+			CHECK(diagnostics[3].begin == at("()\nprint"));
+
+			// Reanalysed if the variables it uses change
+			program.replace(at("{ size = 2 }"), 12, "{ size = add }");
+			diagnostics = analyse(program, engine);
+			CHECK(engine.visitedFunctions() == 3);
+			REQUIRE(diagnostics.size() == 3);
+			CHECK(diagnostics[0].begin == at("(1, 2, 3)"));
+
+			// The operators have their priorities, even if the parser creates a flat chain
+			const std::string priorities = R"~~(
+local n = 1
+if n + 1 < 3 and 'a' .. n == 'a1' then n = -n ^ 2 * 2 end
+local s = not n == nil
+local b = #'abc' + 1 > 2 or (n + 1) * 2
+local e = 1 + 2 .. 'x' < 3
+)~~";
+			engine.clear();
+			diagnostics = analyse(priorities, engine);
+			REQUIRE(diagnostics.size() == 1);
+			CHECK(diagnostics[0].begin == priorities.find("1 + 2 .."));
+			CHECK(diagnostics[0].end == priorities.rfind("< 3") + 3);
+			CHECK(diagnostics[0].message == "Invalid operation '<' between string and number");
+		}
+
+		TEST_CASE("Expression type cache")
+		{
+			int nbCalls = 0;
+			auto countCalls = [&nbCalls](const Scope&, const ast::Arguments&, const TypeInfo&) -> TypeInfo {
+				++nbCalls;
+				return Type::number;
+			};
+
+			UserDefined userDefined;
+			userDefined.addVariable("compute", TypeInfo::createFunction({}, {}, countCalls));
+
+			const std::string program = "local x = compute() * 2\nlocal y = -compute()";
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+
+			ExpressionTypeCache cache;
+			Scope scope{ret.block};
+			scope.setUserDefined(&userDefined);
+			scope.setTypeCache(&cache);
+			analyseBlock(scope, ret.block);
+			CHECK(scope.getVariableType("x").type == Type::number);
+			CHECK(scope.getVariableType("y").type == Type::number);
+			CHECK(nbCalls == 2);
+			CHECK(cache.hits() == 0);
+			CHECK(cache.misses() == cache.size());
+
+			// The same nodes are not evaluated again
+			const auto& statement = boost::get<ast::LocalAssignmentStatement>(ret.block.statements.front().get());
+			const auto& expression = statement.expressions->front();
+			CHECK(getType(scope, expression).type == Type::number);
+			CHECK(getType(scope, expression.operand).type == Type::number); // compute() alone
+			CHECK(nbCalls == 2);
+			CHECK(cache.hits() == 2);
+
+			DiagnosticsEngine engine;
+			CHECK(engine.update(scope, program, ReferenceIndex{scope, program}).empty());
+			CHECK(nbCalls == 2);
+
+			// A new analysis
+			const auto size = cache.size();
+			cache.clear();
+			CHECK(cache.size() == 0);
+			CHECK(cache.hits() == 0);
+			analyseBlock(scope, ret.block);
+			CHECK(nbCalls == 4);
+			CHECK(cache.size() == size);
+
+			// Without the cache
+			scope.setTypeCache(nullptr);
+			getType(scope, expression);
+			CHECK(nbCalls == 5);
+		}
+
+		TEST_CASE("Fixpoint inference")
+		{
+			const std::string program = R"~~(
+local M = {}
+local alias = M.create
+function M.create() return 1 end
+function M.use()
+	local size = config.size
+	local helper = M.helper
+end
+function M.helper() end
+config = { size = 2 }
+
+local A = {}
+local B = { a = A }
+A.b = B
+)~~";
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+
+			auto findVariable = [](const Scope& root, const std::string& name) {
+				for (const auto& child : root.children())
+				{
+					const auto it = child.variables().find(name);
+					if (it != child.variables().end())
+						return it->second;
+				}
+				return TypeInfo{};
+			};
+
+			// Single pass, the types are the ones known at the time of the assignment
+			const auto simple = analyseBlock(ret.block);
+			CHECK(simple.getVariableType("alias").type == Type::nil);
+			CHECK(findVariable(simple, "size").type == Type::nil);
+			CHECK(findVariable(simple, "helper").type == Type::nil);
+			CHECK_FALSE(simple.getVariableType("B").member("a").hasMember("b"));
+
+			Scope scope{ret.block};
+			const auto stats = analyseBlockFixpoint(scope, ret.block);
+			CHECK(scope.getVariableType("alias").type == Type::function);
+			CHECK(findVariable(scope, "size").type == Type::number);
+			CHECK(findVariable(scope, "helper").type == Type::function);
+			CHECK(scope.getVariableType("M").member("use").type == Type::function);
+			CHECK(scope.children().size() == 3);
+
+			// The recursive tables are expanded once per iteration, until the compared depth
+			const auto a = scope.getVariableType("A");
+			CHECK(a.member("b").member("a").member("b").type == Type::table);
+			CHECK(stats.converged);
+			CHECK(stats.iterations == 3);
+
+			// Only the function reading a variable before its definition is analysed again
+			const std::string utils = R"~~(
+local utils = {}
+function utils.first() local x = 1 end
+function utils.second() local y = utils.third end
+function utils.third() end
+)~~";
+			const auto utilsRet = parser::parseBlock(utils);
+			REQUIRE(utilsRet.parsed);
+			Scope utilsScope{utilsRet.block};
+			const auto utilsStats = analyseBlockFixpoint(utilsScope, utilsRet.block);
+			CHECK(utilsStats.converged);
+			CHECK(utilsStats.reanalysed == 1);
+			CHECK(utilsStats.iterations == 2);
+			CHECK(findVariable(utilsScope, "y").type == Type::function);
+			CHECK(findVariable(utilsScope, "x").type == Type::number);
+		}
+
+		TEST_CASE("Function return types")
+		{
+			const std::string program = R"~~(
+local function makePoint(x, y)
+	local p = { x = x, y = y }
+	p.norm = 0
+	return p
+end
+function count(t)
+	if t then return 1 end
+	return nil
+end
+local parse = function(s)
+	if s then return "a", 2 else return 3, 4 end
+end
+local tools = {}
+tools.new = function() return makePoint(1, 2) end
+function tools.name() return "tools" end
+local p = makePoint(1, 2)
+local n = count({})
+local q = tools.new()
+)~~";
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+			const auto scope = analyseBlock(ret.block);
+
+			const auto makePoint = scope.getVariableType("makePoint");
+			REQUIRE(makePoint.function.results.size() == 1);
+			CHECK(makePoint.function.results.front().type == Type::table);
+			CHECK(scope.getVariableType("p").hasMember("norm"));
+			CHECK(scope.getVariableType("q").hasMember("x"));
+
+			// The nil values are ignored if another return gives a type
+			CHECK(scope.getVariableType("n").type == Type::number);
+
+			// Different types at the same position
+			const auto& parseResults = scope.getVariableType("parse").function.results;
+			REQUIRE(parseResults.size() == 2);
+			CHECK(parseResults[0].type == Type::unknown);
+			CHECK(parseResults[1].type == Type::number);
+
+			CHECK(scope.getVariableType("tools").member("name").functionDefinition() == "string function()");
+			REQUIRE(scope.children().size() == 5);
+			CHECK(scope.children()[1].results().size() == 1);
+
+			// A later target of the same assignment can replace the table of the function
+			const std::string replaced = "local t = {}\nt.f, t = function() return 1 end, {}\nt.g, t.h = function() return 'a' end, 2";
+			const auto replacedRet = parser::parseBlock(replaced);
+			REQUIRE(replacedRet.parsed);
+			const auto replacedScope = analyseBlock(replacedRet.block);
+			const auto t = replacedScope.getVariableType("t");
+			CHECK_FALSE(t.hasMember("f"));
+			CHECK(t.member("g").functionDefinition() == "string function()");
+			CHECK(t.member("h").type == Type::number);
+		}
+
+		TEST_CASE("Metatables")
+		{
+			const std::string program = R"~~(
+local Base = {}
+Base.__index = Base
+function Base.new(name)
+	local self = setmetatable({}, Base)
+	self.name = name
+	return self
+end
+function Base:getName() return self.name end
+
+local Derived = setmetatable({}, {__index = Base})
+Derived.__index = Derived
+function Derived.create() return setmetatable({id = 1}, Derived) end
+function Derived:getId() return self.id end
+
+local b = Base.new("x")
+local d = Derived.create()
+local mt = {__index = Derived}
+local e = setmetatable({}, mt)
+local f = setmetatable({}, {__index = {x = 1}})
+local g = d.getId
+local A = setmetatable({}, {__index = B})
+local B = setmetatable({}, {__index = A})
+)~~";
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+			const auto scope = analyseBlock(ret.block);
+
+			// The instances know their class, the members of the class are added when resolving
+			const auto b = scope.getVariableType("b");
+			CHECK(b.type == Type::table);
+			CHECK(b.className == "Base");
+			CHECK(b.name.empty());
+			CHECK(!b.hasMember("getName"));
+			const auto rb = scope.resolve(b);
+			CHECK(rb.hasMember("name"));
+			CHECK(rb.member("getName").isMethod());
+
+			// A table of a user-defined type having the name of a script variable is not an instance
+			TypeInfo named = Type::table;
+			named.name = "Base";
+			CHECK(!scope.resolve(named).hasMember("getName"));
+
+			// The __index chain is flattened
+			const auto rd = scope.resolve(scope.getVariableType("d"));
+			CHECK(rd.className == "Derived");
+			CHECK(rd.hasMember("id"));
+			CHECK(rd.hasMember("getId"));
+			CHECK(rd.hasMember("getName"));
+			CHECK(scope.resolve(scope.getVariableType("e")).hasMember("getName"));
+			CHECK(scope.resolve(scope.getVariableType("Derived")).hasMember("new"));
+			CHECK(scope.getVariableType("g").isMethod());
+
+			// A table given directly as __index is copied
+			CHECK(scope.getVariableType("f").hasMember("x"));
+
+			// The shapes are computed once
+			const auto shape = scope.getClassShape("Derived");
+			REQUIRE(shape);
+			CHECK(shape->hasMember("getName"));
+			CHECK(scope.getClassShape("Derived") == shape);
+			CHECK(!scope.getClassShape("g")); // Not a table
+			CHECK(!scope.getClassShape("unknown"));
+
+			// Loops in the chain
+			CHECK(scope.getClassShape("B"));
+			CHECK(scope.resolve(scope.getVariableType("B")).type == Type::table);
+		}
+
+		TEST_CASE("Lazy analysis")
+		{
+			const std::string program = R"~~(
+local count = 0
+function add(a, b)
+	local function helper(x)
+		local y = x + 1
+		return y
+	end
+	local sum = a + b
+	return helper(sum)
+end
+local t = { name = "t" }
+function t.get() local v = t.name end
+)~~";
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+			Scope scope{ret.block};
+			analyseBlockLazy(scope, ret.block);
+
+			// The global bindings are known, not the bodies
+			CHECK(scope.getVariableType("count").type == Type::number);
+			CHECK(scope.getVariableType("add").type == Type::function);
+			CHECK(scope.getVariableType("add").function.parameters.size() == 2);
+			CHECK(scope.getVariableType("t").hasMember("get"));
+			REQUIRE(scope.children().size() == 2);
+			auto& addScope = scope.modifyChildren()[0];
+			CHECK(addScope.pendingFunction());
+			CHECK(addScope.variables().empty());
+			CHECK(addScope.children().empty());
+
+			// Analysed on demand, the nested functions are still skipped
+			CHECK(analysePendingScope(addScope));
+			CHECK(!analysePendingScope(addScope));
+			CHECK(!addScope.pendingFunction());
+			CHECK(addScope.getVariableType("a").type == Type::unknown);
+			CHECK(addScope.getVariableType("sum").type == Type::number);
+			CHECK(addScope.getVariableType("helper").type == Type::function);
+			REQUIRE(addScope.children().size() == 1);
+			auto& helperScope = addScope.modifyChildren()[0];
+			CHECK(helperScope.pendingFunction());
+			CHECK(analysePendingScope(helperScope));
+			CHECK(helperScope.getVariableType("y").type == Type::number);
+			CHECK(helperScope.results().size() == 1);
+
+			// Same results as the full analysis
+			const auto fullScope = analyseBlock(ret.block);
+			CHECK(analysePendingScope(scope.modifyChildren()[1]));
+			CHECK(scope.children()[1].variables().size() == fullScope.children()[1].variables().size());
+			CHECK(scope.children()[1].getVariableType("v").type == Type::string);
+		}
+
 		TEST_SUITE_END();
 	} // namespace an
 } // namespace lac
@@ -5,13 +5,201 @@
 
 #include <lac/parser/ast.h>
 
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
 namespace lac::an
 {
+	// State of analyseBlockFixpoint. The units analysed again are the root block and the function bodies.
+	class FixpointTracker
+	{
+	public:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+		static constexpr size_t maxComparedDepth = 2; // Of the members, the tables referencing each other grow by one level per iteration
+
+		FixpointTracker(size_t maxIterations);
+
+		size_t beginUnit(Scope& scope, const ast::Block& block, const ast::FunctionBody* body = nullptr, const std::string& name = {});
+		void endUnit();
+
+		void read(const Scope& scope, const std::string& name);
+		void write(const Scope& scope, const std::string& name);
+		TypeInfo merge(TypeInfo type, const TypeInfo& previous) const; // During the next iterations, keep the members found before
+		const Scope* reuse(const ast::Block& block, Scope& parent);     // Move the scope of a nested function that is not analysed again
+
+		FixpointStats run(Scope& scope, const ast::Block& block);
+
+	private:
+		struct Unit
+		{
+			const ast::Block* block = nullptr;
+			const ast::FunctionBody* body = nullptr; // Null for the root block
+			std::string name;                        // Of the function, as it can be called recursively
+			size_t parent = npos;
+			Scope* scope = nullptr;
+			std::set<std::string> externalReads; // Variables read from the parent scopes, or not found
+			std::map<std::string, size_t> hashes; // Of the variables of the unit
+			size_t runs = 0;
+			bool selfDirty = false; // A variable was read before being modified in the same unit
+			size_t resultsHash = 0;
+		};
+
+		struct Frame
+		{
+			size_t unit = 0;
+			std::unordered_map<std::string, std::vector<const void*>> localReads; // Variables of the unit read until now
+		};
+
+		struct Read
+		{
+			size_t unit = 0;
+			const void* binding = nullptr; // Null if the variable was not found
+		};
+
+		static const void* bindingKey(const Scope& scope);
+		bool isInside(size_t unit, size_t ancestor) const;
+		void hashVariables(const Scope& scope, std::map<std::string, size_t>& hashes) const;
+		void collectReusable(std::vector<Scope>& scopes);
+		void refresh(Scope& scope, std::vector<size_t>& nested);
+		void analyseAgain(size_t id);
+
+		size_t m_maxIterations = 0;
+		bool m_refine = false;
+		std::vector<Unit> m_units;
+		std::unordered_map<const ast::Block*, size_t> m_unitIds;
+		std::vector<Frame> m_frames;
+		std::unordered_map<std::string, std::vector<Read>> m_pendingReads; // From the nested functions or not found, by name
+		std::unordered_map<const ast::Block*, Scope*> m_reusable;
+		std::map<size_t, std::set<std::string>> m_changed; // Variables modified by the last analysis of a unit
+		std::set<size_t> m_worklist;                      // Units to analyse again, the outer ones first
+		FixpointStats m_stats;
+	};
+
+	void analyseFunction(Scope& scope, const ast::FunctionBody& fb, const std::string& functionName, FixpointTracker* tracker, bool lazy = false);
+
+	// Types returned by a function, from the return statements of its body and of the blocks inside it
+	class ReturnTypesVisitor : public boost::static_visitor<void>
+	{
+	public:
+		struct Results
+		{
+			std::vector<TypeInfo> types;
+			std::vector<bool> conflicts; // Different types returned at this position
+		};
+
+		ReturnTypesVisitor(const Scope& scope, Results& results)
+			: m_scope(scope)
+			, m_results(results)
+		{
+		}
+
+		template <class T>
+		void operator()(const T&) const
+		{
+			// No block, or the block of a nested function
+		}
+
+		void operator()(const ast::DoStatement& s) const
+		{
+			visitChild(s.block);
+		}
+
+		void operator()(const ast::WhileStatement& s) const
+		{
+			visitChild(s.block);
+		}
+
+		void operator()(const ast::RepeatStatement& s) const
+		{
+			visitChild(s.block);
+		}
+
+		void operator()(const ast::IfThenElseStatement& s) const
+		{
+			visitChild(s.first.block);
+			for (const auto& es : s.rest)
+				visitChild(es.block);
+			if (s.elseBlock)
+				visitChild(*s.elseBlock);
+		}
+
+		void operator()(const ast::NumericalForStatement& s) const
+		{
+			visitChild(s.block);
+		}
+
+		void operator()(const ast::GenericForStatement& s) const
+		{
+			visitChild(s.block);
+		}
+
+		void operator()(const ast::Block& b) const
+		{
+			for (const auto& s : b.statements)
+				boost::apply_visitor(*this, s);
+
+			if (!b.returnStatement)
+				return;
+
+			const auto& expressions = b.returnStatement->expressions;
+			for (size_t i = 0, nb = expressions.size(); i < nb; ++i)
+			{
+				auto type = getType(m_scope, expressions[i]);
+				if (i >= m_results.types.size())
+				{
+					m_results.types.push_back(std::move(type));
+					m_results.conflicts.push_back(false);
+					continue;
+				}
+
+				// Ignore the unknown types, and the nil ones if another return gives a value
+				auto& result = m_results.types[i];
+				if (!type || type.type == result.type || m_results.conflicts[i])
+					continue;
+				if (!result)
+					result = std::move(type);
+				else
+				{
+					result = Type::unknown;
+					m_results.conflicts[i] = true;
+				}
+			}
+		}
+
+	private:
+		void visitChild(const ast::Block& block) const
+		{
+			for (const auto& child : m_scope.children())
+			{
+				if (child.block() == &block)
+				{
+					ReturnTypesVisitor{child, m_results}(block);
+					return;
+				}
+			}
+		}
+
+		const Scope& m_scope;
+		Results& m_results;
+	};
+
+	std::vector<TypeInfo> getReturnTypes(const Scope& scope, const ast::Block& block)
+	{
+		ReturnTypesVisitor::Results results;
+		ReturnTypesVisitor{scope, results}(block);
+		return std::move(results.types);
+	}
+
 	class AnalysisVisitor : public boost::static_visitor<void>
 	{
 	public:
-		AnalysisVisitor(Scope& scope)
+		AnalysisVisitor(Scope& scope, FixpointTracker* tracker = nullptr, bool lazy = false)
 			: m_scope(scope)
+			, m_tracker(tracker)
+			, m_lazy(lazy)
 		{
 		}
 
@@ -30,9 +218,10 @@ namespace lac::an
 			// Nothing to do here
 		}
 
-		void operator()(const std::string&) const
+		void operator()(const std::string& name) const
 		{
-			// Nothing to do here
+			if (m_tracker)
+				m_tracker->read(m_scope, name);
 		}
 
 		void operator()(const ast::UnaryOperation& uo) const
@@ -72,49 +261,27 @@ namespace lac::an
 
 		void operator()(const ast::FunctionBody& fb, const std::string& functionName = {}) const
 		{
-			Scope scope{fb.block, &m_scope};
-			bool isScriptInput = false;
-			if (fb.parameters)
+			if (m_tracker)
 			{
-				// Test if the function has a defined signature
-				if (!functionName.empty())
+				if (const auto scope = m_tracker->reuse(fb.block, m_scope))
 				{
-					const auto userDefined = m_scope.getUserDefined();
-					if (userDefined)
-					{
-						const auto funcType = userDefined->getScriptInput(functionName);
-						if (funcType)
-						{
-							isScriptInput = true;
-
-							// We want to use the given parameter names with the types previously defined
-							const auto& inputParams = funcType->function.parameters;
-							const auto nbInParams = inputParams.size();
-							const auto& funcParams = fb.parameters->parameters;
-							const auto nbFuncParams = funcParams.size();
-							for (size_t i = 0; i < nbFuncParams; ++i)
-							{
-								scope.addVariable(funcParams[i],
-												  i >= nbInParams
-													  ? Type::unknown
-													  : inputParams[i].type());
-							}
-						}
-					}
+					m_lastResults = scope->results();
+					return;
 				}
+			}
 
-				// We do not know the parameter types
-				if (!isScriptInput)
-				{
-					for (const auto& p : fb.parameters->parameters)
-						scope.addVariable(p, Type::unknown);
-
-					if (!functionName.empty())
-						scope.addVariable(functionName, m_scope.getVariableType(functionName)); // The function can be called recursively
-				}
+			Scope scope{fb.block, &m_scope};
+			if (m_lazy)
+			{
+				// Analysed when needed, by analysePendingScope
+				scope.setPendingFunction(&fb, functionName);
+				m_lastResults.clear();
+				m_scope.addChildScope(std::move(scope));
+				return;
 			}
 
-			analyseBlock(scope, fb.block);
+			analyseFunction(scope, fb, functionName, m_tracker);
+			m_lastResults = scope.results();
 			m_scope.addChildScope(std::move(scope));
 		}
 
@@ -209,26 +376,35 @@ namespace lac::an
 		void operator()(const ast::AssignmentStatement& as) const
 		{
 			size_t nbV = as.variables.size(), nbE = as.expressions.size();
+			std::vector<FunctionTarget> functionTargets(nbV); // To add the results of the functions
 			auto varIt = as.variables.begin();
 			for (size_t i = 0; i < nbV; ++i)
 			{
 				TypeInfo type;
 				// TODO: support expressions with multiple returns
-				if (i < nbE)
-					type = getType(m_scope, as.expressions[i]);
-
 				auto& var = *varIt++;
+				if (i < nbE)
+				{
+					type = isIndexField(var)
+							   ? getIndexType(m_scope, as.expressions[i])
+							   : getType(m_scope, as.expressions[i]);
+				}
 
 				if (var.start.get().type() == typeid(std::string))
 				{
 					const auto& varName = boost::get<std::string>(var.start.get());
 					// Named variables
 					if (var.rest.empty())
-						m_scope.addVariable(varName, type);
+					{
+						assign(varName, type);
+						if (i < nbE && isFunction(as.expressions[i]))
+							functionTargets[i].name = &varName;
+					}
 					else
 					{
-						auto& tableType = m_scope.modifyTable(varName);
+						auto& tableType = modifyTable(varName);
 						auto* memberType = &tableType;
+						std::vector<const std::string*> memberNames;
 
 						// Table member
 						for (const auto& restIt : var.rest)
@@ -239,6 +415,7 @@ namespace lac::an
 							{
 								const auto& memberName = boost::get<ast::TableIndexName>(memberExp).name;
 								memberType = &memberType->members[memberName];
+								memberNames.push_back(&memberName);
 							}
 							else // TODO: TableIndexExpression & VariableFunctionCall
 							{
@@ -248,7 +425,11 @@ namespace lac::an
 						}
 
 						if (memberType)
-							*memberType = type;
+						{
+							assignMember(*memberType, type);
+							if (i < nbE && isFunction(as.expressions[i]))
+								functionTargets[i] = {&varName, std::move(memberNames)};
+						}
 					}
 				}
 
@@ -256,8 +437,15 @@ namespace lac::an
 			}
 
 			// Visit expressions, add child scopes
-			for (const auto& e : as.expressions)
-				(*this)(e);
+			for (size_t i = 0; i < nbE; ++i)
+			{
+				(*this)(as.expressions[i]);
+				if (i < nbV && functionTargets[i].name)
+				{
+					if (auto type = findTarget(functionTargets[i]))
+						setResults(*functionTargets[i].name, *type);
+				}
+			}
 		}
 
 		void operator()(const ast::LabelStatement& ls) const
@@ -276,33 +464,33 @@ namespace lac::an
 
 		void operator()(const ast::DoStatement& ds) const
 		{
-			m_scope.addChildScope(analyseBlock(ds.block, &m_scope));
+			m_scope.addChildScope(analyseChild(ds.block));
 		}
 
 		void operator()(const ast::WhileStatement& ws) const
 		{
-			m_scope.addChildScope(analyseBlock(ws.block, &m_scope));
+			m_scope.addChildScope(analyseChild(ws.block));
 		}
 
 		void operator()(const ast::RepeatStatement& rs) const
 		{
-			m_scope.addChildScope(analyseBlock(rs.block, &m_scope));
+			m_scope.addChildScope(analyseChild(rs.block));
 		}
 
 		void operator()(const ast::IfThenElseStatement& s) const
 		{
-			m_scope.addChildScope(analyseBlock(s.first.block, &m_scope));
+			m_scope.addChildScope(analyseChild(s.first.block));
 			for (const auto& es : s.rest)
-				m_scope.addChildScope(analyseBlock(es.block, &m_scope));
+				m_scope.addChildScope(analyseChild(es.block));
 			if (s.elseBlock)
-				m_scope.addChildScope(analyseBlock(*s.elseBlock, &m_scope));
+				m_scope.addChildScope(analyseChild(*s.elseBlock));
 		}
 
 		void operator()(const ast::NumericalForStatement& s) const
 		{
 			Scope scope{s.block, &m_scope};
 			scope.addVariable(s.variable, Type::number);
-			analyseBlock(scope, s.block);
+			AnalysisVisitor{scope, m_tracker, m_lazy}(s.block);
 			m_scope.addChildScope(std::move(scope));
 		}
 
@@ -337,7 +525,7 @@ namespace lac::an
 				}
 			}
 
-			analyseBlock(scope, s.block);
+			AnalysisVisitor{scope, m_tracker, m_lazy}(s.block);
 			m_scope.addChildScope(std::move(scope));
 		}
 
@@ -348,13 +536,14 @@ namespace lac::an
 			// Global function
 			if (s.name.rest.empty() && !s.name.member)
 			{
-				m_scope.addVariable(s.name.start, std::move(funcType));
+				assign(s.name.start, std::move(funcType));
 				(*this)(s.body, s.name.start);
+				setResults(s.name.start, m_scope.modifyTable(s.name.start));
 				return;
 			}
 
 			// Declaration of a table function or method
-			auto& tableType = m_scope.modifyTable(s.name.start);
+			auto& tableType = modifyTable(s.name.start);
 			auto* memberType = &tableType;
 
 			// Table member
@@ -369,17 +558,19 @@ namespace lac::an
 					memberType = &memberType->members[s.name.member->name];
 				}
 
-				*memberType = funcType;
+				assignMember(*memberType, std::move(funcType));
 			}
 			
 			(*this)(s.body); // Visit the body scope
+			setResults(s.name.start, *memberType);
 		}
 
 		void operator()(const ast::LocalFunctionDeclarationStatement& s) const
 		{
 			auto funcType = getType(m_scope, s.body);
-			m_scope.addVariable(s.name, std::move(funcType));
+			assign(s.name, std::move(funcType));
 			(*this)(s.body, s.name);
+			setResults(s.name, m_scope.modifyTable(s.name));
 		}
 
 		void operator()(const ast::LocalAssignmentStatement& s) const
@@ -387,7 +578,7 @@ namespace lac::an
 			if (!s.expressions)
 			{
 				for (const auto& v : s.variables)
-					m_scope.addVariable(v, {Type::unknown});
+					assign(v, {Type::unknown});
 			}
 			else
 			{
@@ -399,12 +590,16 @@ namespace lac::an
 					// TODO: support expressions with multiple returns
 					if (i < nbE)
 						type = getType(m_scope, expressions[i]);
-					m_scope.addVariable(s.variables[i], type);
+					assign(s.variables[i], std::move(type));
 				}
 
 				// Visit expressions, add child scopes
-				for (const auto& e : *s.expressions)
-					(*this)(e);
+				for (size_t i = 0; i < nbE; ++i)
+				{
+					(*this)(expressions[i]);
+					if (i < nbV && isFunction(expressions[i]))
+						setResults(s.variables[i], m_scope.modifyTable(s.variables[i]));
+				}
 			}
 		}
 
@@ -417,12 +612,169 @@ namespace lac::an
 		}
 
 	private:
+		static bool isFunction(const ast::Expression& e)
+		{
+			return !e.binaryOperation && e.operand.get().type() == typeid(ast::f_FunctionBody);
+		}
+
+		static bool isIndexField(const ast::Variable& var)
+		{
+			if (var.rest.empty() || var.rest.back().get().type() != typeid(ast::TableIndexName))
+				return false;
+			return boost::get<ast::TableIndexName>(var.rest.back().get()).name == "__index";
+		}
+
+		struct FunctionTarget
+		{
+			const std::string* name = nullptr;
+			std::vector<const std::string*> members; // Path to the member, if not the variable itself
+		};
+
+		// Looked up after all the assignments of the statement, as a later target can replace the table of a previous one
+		TypeInfo* findTarget(const FunctionTarget& target) const
+		{
+			auto* type = &m_scope.modifyTable(*target.name);
+			for (const auto member : target.members)
+			{
+				const auto it = type->members.find(*member);
+				if (it == type->members.end())
+					return nullptr;
+				type = &it->second;
+			}
+			return type;
+		}
+
+		// Add the types returned by the last visited function to its variable
+		void setResults(const std::string& variable, TypeInfo& type) const
+		{
+			auto& function = type.function;
+			if (type.type != Type::function || !function.results.empty() || function.getResultTypeFunc || m_lastResults.empty())
+				return;
+
+			if (m_tracker)
+				m_tracker->write(m_scope, variable);
+			function.results = m_lastResults;
+		}
+
+		Scope analyseChild(const ast::Block& block) const
+		{
+			Scope scope{block, &m_scope};
+			AnalysisVisitor{scope, m_tracker, m_lazy}(block);
+			return scope;
+		}
+
+		void assign(const std::string& name, TypeInfo type) const
+		{
+			if (m_tracker)
+			{
+				m_tracker->write(m_scope, name);
+				const auto it = m_scope.variables().find(name);
+				if (it != m_scope.variables().end())
+					type = m_tracker->merge(std::move(type), it->second);
+			}
+			m_scope.addVariable(name, std::move(type));
+		}
+
+		TypeInfo& modifyTable(const std::string& name) const
+		{
+			if (m_tracker)
+				m_tracker->write(m_scope, name);
+			return m_scope.modifyTable(name);
+		}
+
+		void assignMember(TypeInfo& member, TypeInfo type) const
+		{
+			member = m_tracker
+						 ? m_tracker->merge(std::move(type), member)
+						 : std::move(type);
+		}
+
 		Scope& m_scope;
+		FixpointTracker* m_tracker = nullptr;
+		bool m_lazy = false; // Do not analyse the function bodies
+		mutable std::vector<TypeInfo> m_lastResults; // Of the last function body visited
 	};
 
+	void analyseFunction(Scope& scope, const ast::FunctionBody& fb, const std::string& functionName, FixpointTracker* tracker, bool lazy)
+	{
+		if (tracker)
+			tracker->beginUnit(scope, fb.block, &fb, functionName);
+
+		const auto& parentScope = *scope.parent();
+		bool isScriptInput = false;
+		if (fb.parameters)
+		{
+			// Test if the function has a defined signature
+			if (!functionName.empty())
+			{
+				const auto userDefined = parentScope.getUserDefined();
+				if (userDefined)
+				{
+					const auto funcType = userDefined->getScriptInput(functionName);
+					if (funcType)
+					{
+						isScriptInput = true;
+
+						// We want to use the given parameter names with the types previously defined
+						const auto& inputParams = funcType->function.parameters;
+						const auto nbInParams = inputParams.size();
+						const auto& funcParams = fb.parameters->parameters;
+						const auto nbFuncParams = funcParams.size();
+						for (size_t i = 0; i < nbFuncParams; ++i)
+						{
+							scope.addVariable(funcParams[i],
+											  i >= nbInParams
+												  ? Type::unknown
+												  : inputParams[i].type());
+						}
+					}
+				}
+			}
+
+			// We do not know the parameter types
+			if (!isScriptInput)
+			{
+				for (const auto& p : fb.parameters->parameters)
+					scope.addVariable(p, Type::unknown);
+
+				if (!functionName.empty())
+				{
+					if (tracker)
+						tracker->read(scope, functionName);
+					scope.addVariable(functionName, parentScope.getVariableType(functionName)); // The function can be called recursively
+				}
+			}
+		}
+
+		AnalysisVisitor{scope, tracker, lazy}(fb.block);
+		scope.setResults(getReturnTypes(scope, fb.block));
+		if (tracker)
+			tracker->endUnit();
+	}
+
 	void analyseBlock(Scope& scope, const ast::Block& block)
 	{
 		AnalysisVisitor{scope}(block);
+		scope.clearClassShapes();
+	}
+
+	void analyseBlockLazy(Scope& scope, const ast::Block& block)
+	{
+		AnalysisVisitor{scope, nullptr, true}(block);
+		scope.clearClassShapes();
+	}
+
+	bool analysePendingScope(Scope& scope)
+	{
+		const auto function = scope.pendingFunction();
+		if (!function)
+			return false;
+
+		const auto name = scope.pendingFunctionName();
+		scope.setPendingFunction(nullptr);
+		analyseFunction(scope, *function, name, nullptr, true);
+		scope.clearClassShapes();
+		return true;
 	}
 
 	Scope analyseBlock(const ast::Block& block, Scope* parentScope)
@@ -431,4 +783,316 @@ namespace lac::an
 		analyseBlock(scope, block);
 		return scope;
 	}
+
+	FixpointStats analyseBlockFixpoint(Scope& scope, const ast::Block& block, size_t maxIterations)
+	{
+		FixpointTracker tracker{std::max<size_t>(maxIterations, 1)};
+		const auto stats = tracker.run(scope, block);
+		scope.clearClassShapes();
+		return stats;
+	}
+
+	FixpointTracker::FixpointTracker(size_t maxIterations)
+		: m_maxIterations(maxIterations)
+	{
+	}
+
+	size_t FixpointTracker::beginUnit(Scope& scope, const ast::Block& block, const ast::FunctionBody* body, const std::string& name)
+	{
+		auto it = m_unitIds.find(&block);
+		if (it == m_unitIds.end())
+		{
+			Unit unit;
+			unit.block = &block;
+			unit.body = body;
+			unit.name = name;
+			unit.parent = m_frames.empty() ? npos : m_frames.back().unit;
+			it = m_unitIds.emplace(&block, m_units.size()).first;
+			m_units.push_back(std::move(unit));
+		}
+
+		const auto id = it->second;
+		auto& unit = m_units[id];
+		unit.scope = &scope;
+		unit.externalReads.clear();
+		unit.selfDirty = false;
+		++unit.runs;
+		m_stats.iterations = std::max(m_stats.iterations, unit.runs);
+
+		m_frames.push_back({id, {}});
+		return id;
+	}
+
+	void FixpointTracker::endUnit()
+	{
+		const auto id = m_frames.back().unit;
+		m_frames.pop_back();
+
+		auto& unit = m_units[id];
+		std::map<std::string, size_t> hashes;
+		hashVariables(*unit.scope, hashes);
+
+		if (unit.runs > 1)
+		{
+			std::set<std::string> changed;
+			for (const auto& [name, hash] : hashes)
+			{
+				const auto previous = unit.hashes.find(name);
+				if (previous == unit.hashes.end() || previous->second != hash)
+					changed.insert(name);
+			}
+			for (const auto& previous : unit.hashes)
+			{
+				if (!hashes.count(previous.first))
+					changed.insert(previous.first);
+			}
+
+			if (changed.empty())
+				unit.selfDirty = false; // Stable, even if some variables are still read before being modified
+			else
+				m_changed[id] = std::move(changed);
+		}
+
+		unit.hashes = std::move(hashes);
+		if (unit.selfDirty)
+			m_worklist.insert(id);
+
+		// The parent unit gives the returned types to the variable of the function
+		size_t resultsHash = 0;
+		for (const auto& result : unit.scope->results())
+			boost::hash_combine(resultsHash, hashType(result, maxComparedDepth));
+		if (unit.runs > 1 && resultsHash != unit.resultsHash && unit.parent != npos)
+			m_worklist.insert(unit.parent);
+		unit.resultsHash = resultsHash;
+	}
+
+	void FixpointTracker::read(const Scope& scope, const std::string& name)
+	{
+		auto& frame = m_frames.back();
+		auto& unit = m_units[frame.unit];
+
+		bool external = false;
+		const Scope* definition = &scope;
+		for (; definition; definition = definition->parent())
+		{
+			if (definition->variables().count(name))
+				break;
+			if (definition == unit.scope)
+				external = true;
+		}
+
+		if (definition && !external)
+		{
+			auto& reads = frame.localReads[name];
+			const auto key = bindingKey(*definition);
+			if (reads.empty() || reads.back() != key)
+				reads.push_back(key);
+			return;
+		}
+
+		unit.externalReads.insert(name);
+		auto& reads = m_pendingReads[name];
+		const Read read{frame.unit, definition ? bindingKey(*definition) : nullptr};
+		if (reads.empty() || reads.back().unit != read.unit || reads.back().binding != read.binding)
+			reads.push_back(read);
+	}
+
+	void FixpointTracker::write(const Scope& scope, const std::string& name)
+	{
+		auto& frame = m_frames.back();
+		const auto key = bindingKey(scope);
+
+		// Variable of this unit read before this assignment
+		const auto localIt = frame.localReads.find(name);
+		if (localIt != frame.localReads.end())
+		{
+			auto& keys = localIt->second;
+			if (std::find(keys.begin(), keys.end(), key) != keys.end())
+			{
+				m_units[frame.unit].selfDirty = true;
+				frame.localReads.erase(localIt);
+			}
+		}
+
+		// Read before by a nested function, or not found when read
+		const auto pendingIt = m_pendingReads.find(name);
+		if (pendingIt == m_pendingReads.end())
+			return;
+
+		auto& reads = pendingIt->second;
+		const auto end = std::remove_if(reads.begin(), reads.end(), [&](const Read& read) {
+			if (read.binding != key && (read.binding || !isInside(read.unit, frame.unit)))
+				return false;
+
+			if (read.unit == frame.unit)
+				m_units[read.unit].selfDirty = true;
+			else
+				m_worklist.insert(read.unit);
+			return true;
+		});
+		reads.erase(end, reads.end());
+	}
+
+	TypeInfo FixpointTracker::merge(TypeInfo type, const TypeInfo& previous) const
+	{
+		if (!m_refine || type.type != Type::table || previous.type != Type::table)
+			return type;
+
+		for (const auto& [name, member] : previous.members)
+		{
+			const auto it = type.members.find(name);
+			if (it == type.members.end())
+				type.members.emplace(name, member);
+			else
+				it->second = merge(std::move(it->second), member);
+		}
+		return type;
+	}
+
+	const Scope* FixpointTracker::reuse(const ast::Block& block, Scope& parent)
+	{
+		const auto it = m_reusable.find(&block);
+		if (it == m_reusable.end())
+			return nullptr;
+
+		const auto scope = it->second;
+		m_reusable.erase(it);
+		return &parent.addChildScope(std::move(*scope));
+	}
+
+	FixpointStats FixpointTracker::run(Scope& scope, const ast::Block& block)
+	{
+		// The types of the expressions change between the iterations
+		auto& globalScope = scope.getGlobalScope();
+		const auto typeCache = globalScope.getTypeCache();
+		globalScope.setTypeCache(nullptr);
+
+		beginUnit(scope, block);
+		AnalysisVisitor{scope, this}(block);
+		endUnit();
+
+		std::vector<size_t> nested;
+		refresh(scope, nested);
+
+		m_refine = true;
+		while (!m_worklist.empty())
+		{
+			const auto id = *m_worklist.begin();
+			m_worklist.erase(m_worklist.begin());
+			if (m_units[id].runs >= m_maxIterations)
+			{
+				m_stats.converged = false;
+				continue;
+			}
+
+			analyseAgain(id);
+		}
+
+		if (typeCache)
+			typeCache->clear();
+		globalScope.setTypeCache(typeCache);
+		return m_stats;
+	}
+
+	const void* FixpointTracker::bindingKey(const Scope& scope)
+	{
+		// The scopes are moved during the analysis, but not the blocks
+		if (scope.block())
+			return scope.block();
+		return &scope;
+	}
+
+	bool FixpointTracker::isInside(size_t unit, size_t ancestor) const
+	{
+		for (; unit != npos; unit = m_units[unit].parent)
+		{
+			if (unit == ancestor)
+				return true;
+		}
+		return false;
+	}
+
+	void FixpointTracker::hashVariables(const Scope& scope, std::map<std::string, size_t>& hashes) const
+	{
+		for (const auto& [name, type] : scope.variables())
+			boost::hash_combine(hashes[name], hashType(type, maxComparedDepth));
+
+		for (const auto& child : scope.children())
+		{
+			if (!m_unitIds.count(child.block()))
+				hashVariables(child, hashes);
+		}
+	}
+
+	void FixpointTracker::collectReusable(std::vector<Scope>& scopes)
+	{
+		for (auto& child : scopes)
+		{
+			if (m_unitIds.count(child.block()))
+				m_reusable[child.block()] = &child;
+			else
+				collectReusable(child.modifyChildren());
+		}
+	}
+
+	void FixpointTracker::refresh(Scope& scope, std::vector<size_t>& nested)
+	{
+		for (auto& child : scope.modifyChildren())
+		{
+			const auto it = m_unitIds.find(child.block());
+			if (it != m_unitIds.end())
+			{
+				m_units[it->second].scope = &child;
+				nested.push_back(it->second);
+			}
+			refresh(child, nested);
+		}
+	}
+
+	void FixpointTracker::analyseAgain(size_t id)
+	{
+		++m_stats.reanalysed;
+		auto& target = *m_units[id].scope;
+		const auto previousVariables = target.variables();
+		auto previousChildren = std::move(target.modifyChildren());
+		target.reset();
+
+		// The nested functions are analysed again only if they read a modified variable
+		m_reusable.clear();
+		collectReusable(previousChildren);
+
+		// Start from the previous types, for the variables read before being assigned
+		for (const auto& [name, type] : previousVariables)
+			target.addVariable(name, type);
+
+		const auto body = m_units[id].body;
+		if (body)
+		{
+			const auto name = m_units[id].name;
+			analyseFunction(target, *body, name, this);
+		}
+		else
+		{
+			const auto& block = *m_units[id].block;
+			beginUnit(target, block);
+			AnalysisVisitor{target, this}(block);
+			endUnit();
+		}
+
+		std::vector<size_t> nested;
+		refresh(target, nested);
+
+		const auto changedIt = m_changed.find(id);
+		if (changedIt == m_changed.end())
+			return;
+
+		const auto changed = std::move(changedIt->second);
+		m_changed.erase(changedIt);
+		for (const auto n : nested)
+		{
+			const auto& reads = m_units[n].externalReads;
+			if (std::any_of(changed.begin(), changed.end(), [&reads](const std::string& name) { return reads.count(name) != 0; }))
+				m_worklist.insert(n);
+		}
+	}
 } // namespace lac::an
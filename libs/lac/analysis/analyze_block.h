@@ -10,7 +10,27 @@ namespace lac
 	}
 	namespace an
 	{
-		void analyseBlock(Scope& scope, const ast::Block& block);
-		Scope analyseBlock(const ast::Block& block, Scope* parentScope = nullptr);
+		CORE_API void analyseBlock(Scope& scope, const ast::Block& block);
+		CORE_API Scope analyseBlock(const ast::Block& block, Scope* parentScope = nullptr);
+
+		// Only the statements outside of the functions are analysed, for the large files: the scopes of the function bodies
+		// are added empty, and analysed by analysePendingScope the first time they are needed (see Completion::setLazyAnalysis).
+		// The types returned by the functions are not inferred in this mode.
+		CORE_API void analyseBlockLazy(Scope& scope, const ast::Block& block);
+
+		// Analyse the body of a function skipped by analyseBlockLazy, its nested functions being skipped in the same way.
+		// The parent of the scope must have been analysed. Returns false if the scope was already analysed.
+		CORE_API bool analysePendingScope(Scope& scope);
+
+		struct CORE_API FixpointStats
+		{
+			size_t iterations = 0; // Most analyses of a same function
+			size_t reanalysed = 0; // Functions (or the root block) analysed again after the first pass
+			bool converged = true; // False if some types were still changing after the maximum number of iterations
+		};
+
+		// Same as analyseBlock, then the functions having read a variable before its last assignment are analysed again, until their types do not change.
+		// Only the functions reading a modified variable are visited again, each one at most maxIterations times.
+		CORE_API FixpointStats analyseBlockFixpoint(Scope& scope, const ast::Block& block, size_t maxIterations = 4);
 	} // namespace an
 } // namespace lac
@@ -0,0 +1,804 @@
+#include <lac/analysis/diagnostics.h>
+#include <lac/analysis/get_type.h>
+#include <lac/analysis/references.h>
+#include <lac/analysis/scope.h>
+#include <lac/parser/ast.h>
+
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace
+{
+	using lac::an::Type;
+	using lac::an::TypeInfo;
+
+	// Globals of the Lua standard libraries, they are not defined in the scripts
+	bool isStandardGlobal(std::string_view name)
+	{
+		static const std::unordered_set<std::string_view> globals = {
+			"_ENV", "_G", "_VERSION", "arg", "assert", "bit32", "collectgarbage", "coroutine", "debug",
+			"dofile", "error", "getfenv", "getmetatable", "io", "ipairs", "load", "loadfile", "loadstring",
+			"math", "module", "next", "os", "package", "pairs", "pcall", "print", "rawequal", "rawget",
+			"rawlen", "rawset", "require", "select", "setfenv", "setmetatable", "string", "table",
+			"tonumber", "tostring", "type", "unpack", "utf8", "xpcall"};
+		return globals.count(name) != 0;
+	}
+
+	// The types we are sure of: the tables and userdata can have metamethods, and the other ones are not known
+	bool isDefinite(const TypeInfo& type)
+	{
+		return type.type == Type::boolean
+			   || type.type == Type::number
+			   || type.type == Type::string
+			   || type.type == Type::function;
+	}
+
+	std::string_view operationText(lac::ast::Operation operation)
+	{
+		using OP = lac::ast::Operation;
+		switch (operation)
+		{
+		case OP::add: return "+";
+		case OP::sub: return "-";
+		case OP::mul: return "*";
+		case OP::div: return "/";
+		case OP::idiv: return "//";
+		case OP::mod: return "%";
+		case OP::pow: return "^";
+		case OP::unm: return "-";
+		case OP::band: return "&";
+		case OP::bor: return "|";
+		case OP::bxor: return "~";
+		case OP::bnot: return "~";
+		case OP::shl: return "<<";
+		case OP::shr: return ">>";
+		case OP::concat: return "..";
+		case OP::len: return "#";
+		case OP::lt: return "<";
+		case OP::le: return "<=";
+		case OP::gt: return ">";
+		case OP::ge: return ">=";
+		case OP::eq: return "==";
+		case OP::ineq: return "~=";
+		case OP::lnot: return "not";
+		case OP::land: return "and";
+		case OP::lor: return "or";
+		default: return "?";
+		}
+	}
+
+	// Priorities of the binary operators in Lua, from the lowest
+	int precedence(lac::ast::Operation operation)
+	{
+		using OP = lac::ast::Operation;
+		switch (operation)
+		{
+		case OP::lor: return 1;
+		case OP::land: return 2;
+		case OP::lt:
+		case OP::le:
+		case OP::gt:
+		case OP::ge:
+		case OP::eq:
+		case OP::ineq: return 3;
+		case OP::bor: return 4;
+		case OP::bxor: return 5;
+		case OP::band: return 6;
+		case OP::shl:
+		case OP::shr: return 7;
+		case OP::concat: return 8;
+		case OP::add:
+		case OP::sub: return 9;
+		case OP::mul:
+		case OP::div:
+		case OP::idiv:
+		case OP::mod: return 10;
+		case OP::pow: return 12;
+		default: return 0;
+		}
+	}
+
+	constexpr int unaryPrecedence = 11; // Only the exponentiation has a higher priority
+
+	bool isRightAssociative(lac::ast::Operation operation)
+	{
+		return operation == lac::ast::Operation::concat || operation == lac::ast::Operation::pow;
+	}
+
+	// Type stored in a scope or a parent type, to not copy the big tables at each member access
+	class TypeRef
+	{
+	public:
+		TypeRef(const TypeInfo* type)
+			: m_type(type)
+		{
+		}
+
+		TypeRef(TypeInfo type)
+			: m_value(std::move(type))
+		{
+		}
+
+		const TypeInfo& get() const
+		{
+			return m_type ? *m_type : m_value;
+		}
+
+		// Part of this type, copied if this one is
+		TypeRef part(const TypeInfo& type) const
+		{
+			if (m_type)
+				return &type;
+			return type;
+		}
+
+	private:
+		const TypeInfo* m_type = nullptr;
+		TypeInfo m_value;
+	};
+
+	// The last argument can give any number of values
+	bool hasMultipleValues(const lac::ast::Expression& e)
+	{
+		if (e.binaryOperation)
+			return false;
+
+		const auto& operand = e.operand.get();
+		if (operand.type() == typeid(lac::ast::ExpressionConstant))
+			return boost::get<lac::ast::ExpressionConstant>(operand) == lac::ast::ExpressionConstant::dots;
+
+		if (operand.type() == typeid(lac::ast::f_PrefixExpression))
+		{
+			const auto& pe = boost::get<lac::ast::f_PrefixExpression>(operand).get();
+			return !pe.rest.empty() && pe.rest.back().get().type() == typeid(lac::ast::FunctionCallEnd);
+		}
+
+		return false;
+	}
+} // namespace
+
+namespace lac::an
+{
+	class DiagnosticsEngine::Visitor : public boost::static_visitor<void>
+	{
+	public:
+		Visitor(DiagnosticsEngine& engine, std::string_view text, const Scope& scope, std::vector<size_t>* nested = nullptr)
+			: m_engine(engine)
+			, m_text(text)
+			, m_scope(scope)
+			, m_nested(nested)
+		{
+		}
+
+		void operator()(const ast::ExpressionConstant&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::Numeral&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::LiteralString&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const std::string&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::UnaryOperation& uo) const
+		{
+			(*this)(uo.expression);
+		}
+
+		void operator()(const ast::FieldByExpression& f) const
+		{
+			(*this)(f.key);
+			(*this)(f.value);
+		}
+
+		void operator()(const ast::FieldByAssignment& f) const
+		{
+			(*this)(f.value);
+		}
+
+		void operator()(const ast::Field& f) const
+		{
+			boost::apply_visitor(*this, f);
+		}
+
+		void operator()(const ast::TableConstructor& tc) const
+		{
+			if (tc.fields)
+			{
+				for (const auto& f : *tc.fields)
+					(*this)(f);
+			}
+		}
+
+		// A function is a unit of the cache, it is only visited if its text or its environment changed
+		void operator()(const ast::FunctionBody& fb) const
+		{
+			const auto& block = fb.block;
+			const auto it = m_engine.m_scopes.find(&block);
+			if (block.begin > block.end || it == m_engine.m_scopes.end())
+				return; // Nothing to check in an empty body
+
+			std::string text;
+			if (fb.parameters)
+			{
+				for (const auto& p : fb.parameters->parameters)
+					text += p + ',';
+				if (fb.parameters->varargs)
+					text += "...";
+			}
+			text += ')';
+			text += m_text.substr(block.begin, block.end + 1 - block.begin);
+
+			const auto environment = it->second.environment;
+			auto key = std::hash<std::string>{}(text);
+			boost::hash_combine(key, environment);
+
+			if (m_nested)
+				m_nested->push_back(key);
+
+			auto& diagnostics = m_engine.m_diagnostics;
+			if (const auto unit = m_engine.reuseUnit(key, text, environment))
+			{
+				for (auto diagnostic : unit->diagnostics)
+				{
+					diagnostic.begin += block.begin;
+					diagnostic.end += block.begin;
+					diagnostics.push_back(std::move(diagnostic));
+				}
+				return;
+			}
+
+			++m_engine.m_visitedFunctions;
+			Unit unit;
+			unit.text = std::move(text);
+			unit.environment = environment;
+			const auto first = diagnostics.size();
+			Visitor{m_engine, m_text, *it->second.scope, &unit.nested}(block);
+
+			for (auto i = first; i < diagnostics.size(); ++i)
+			{
+				auto diagnostic = diagnostics[i];
+				diagnostic.begin -= block.begin;
+				diagnostic.end -= block.begin;
+				unit.diagnostics.push_back(std::move(diagnostic));
+			}
+			m_engine.m_units.emplace(key, std::move(unit));
+		}
+
+		void operator()(const ast::Operand& op) const
+		{
+			boost::apply_visitor(*this, op);
+		}
+
+		void operator()(const ast::Expression& e) const
+		{
+			Chain chain;
+			flatten(e, chain);
+			for (const auto& item : chain)
+			{
+				if (item.operand)
+					(*this)(*item.operand);
+			}
+
+			if (chain.size() > 1)
+			{
+				size_t pos = 0;
+				evaluate(chain, pos, 0, true);
+			}
+		}
+
+		void operator()(const ast::ExpressionsList& el) const
+		{
+			for (const auto& ex : el)
+				(*this)(ex);
+		}
+
+		void operator()(const ast::BracketedExpression& be) const
+		{
+			(*this)(be.expression);
+		}
+
+		void operator()(const ast::TableIndexExpression& tie) const
+		{
+			(*this)(tie.expression);
+		}
+
+		void operator()(const ast::EmptyArguments&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::PrefixExpression& pe) const
+		{
+			std::string name;
+			auto type = start(pe.start, name);
+			for (const auto& pp : pe.rest)
+			{
+				const auto& ppType = pp.get().type();
+				if (ppType == typeid(ast::TableIndexName))
+					type = index(type, name, boost::get<ast::TableIndexName>(pp));
+				else if (ppType == typeid(ast::TableIndexExpression))
+					type = index(type, name, boost::get<ast::TableIndexExpression>(pp));
+				else
+					type = call(type, name, boost::get<ast::FunctionCallEnd>(pp), &pp != &pe.rest.back());
+			}
+		}
+
+		void operator()(const ast::Variable& v) const
+		{
+			std::string name;
+			auto type = start(v.start, name);
+			for (const auto& vp : v.rest)
+				type = variablePostfix(type, name, vp);
+		}
+
+		void operator()(const ast::FunctionCall& fc) const
+		{
+			std::string name;
+			auto type = start(fc.start, name);
+			for (const auto& r : fc.rest)
+			{
+				if (r.tableIndex)
+				{
+					if (r.tableIndex->get().type() == typeid(ast::TableIndexName))
+						type = index(type, name, boost::get<ast::TableIndexName>(*r.tableIndex));
+					else
+						type = index(type, name, boost::get<ast::TableIndexExpression>(*r.tableIndex));
+				}
+				type = call(type, name, r.functionCall, &r != &fc.rest.back());
+			}
+		}
+
+		void operator()(const ast::ReturnStatement& rs) const
+		{
+			for (const auto& ex : rs.expressions)
+				(*this)(ex);
+		}
+
+		void operator()(const ast::EmptyStatement&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::AssignmentStatement& as) const
+		{
+			for (const auto& v : as.variables)
+				(*this)(v);
+			(*this)(as.expressions);
+		}
+
+		void operator()(const ast::LabelStatement&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::GotoStatement&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::BreakStatement&) const
+		{
+			// Nothing to do here
+		}
+
+		void operator()(const ast::DoStatement& ds) const
+		{
+			childBlock(ds.block);
+		}
+
+		void operator()(const ast::WhileStatement& ws) const
+		{
+			(*this)(ws.condition);
+			childBlock(ws.block);
+		}
+
+		void operator()(const ast::RepeatStatement& rs) const
+		{
+			childBlock(rs.block, &rs.condition); // The condition can use the locals of the block
+		}
+
+		void operator()(const ast::IfThenElseStatement& s) const
+		{
+			(*this)(s.first.condition);
+			childBlock(s.first.block);
+			for (const auto& es : s.rest)
+			{
+				(*this)(es.condition);
+				childBlock(es.block);
+			}
+			if (s.elseBlock)
+				childBlock(*s.elseBlock);
+		}
+
+		void operator()(const ast::NumericalForStatement& s) const
+		{
+			(*this)(s.first);
+			(*this)(s.last);
+			if (s.step)
+				(*this)(*s.step);
+			childBlock(s.block);
+		}
+
+		void operator()(const ast::GenericForStatement& s) const
+		{
+			(*this)(s.expressions);
+			childBlock(s.block);
+		}
+
+		void operator()(const ast::FunctionDeclarationStatement& s) const
+		{
+			(*this)(s.body);
+		}
+
+		void operator()(const ast::LocalFunctionDeclarationStatement& s) const
+		{
+			(*this)(s.body);
+		}
+
+		void operator()(const ast::LocalAssignmentStatement& s) const
+		{
+			if (s.expressions)
+				(*this)(*s.expressions);
+		}
+
+		void operator()(const ast::Block& b) const
+		{
+			for (const auto& s : b.statements)
+				boost::apply_visitor(*this, s);
+			if (b.returnStatement)
+				(*this)(*b.returnStatement);
+		}
+
+	private:
+		// The parser creates a flat chain of operations without priorities, where a unary operation applies to the rest
+		// of the chain. It is read again as a list of operands and operators, to apply the precedences of Lua.
+		struct ChainItem
+		{
+			const ast::Operand* operand = nullptr; // Null for an operator
+			ast::Operation operation = ast::Operation::add;
+			size_t begin = 0; // Of the unary operators
+		};
+		using Chain = std::vector<ChainItem>;
+
+		struct Value
+		{
+			TypeInfo type;
+			size_t begin = 0, end = 0; // End excluded
+		};
+
+		static void flatten(const ast::Expression& e, Chain& chain)
+		{
+			for (auto ex = &e; ex; ex = ex->binaryOperation ? &ex->binaryOperation->get().expression : nullptr)
+			{
+				const auto& op = ex->operand;
+				if (op.get().type() == typeid(ast::f_UnaryOperation))
+				{
+					const auto& uo = boost::get<ast::f_UnaryOperation>(op.get()).get();
+					chain.push_back({nullptr, uo.operation, op.begin});
+					flatten(uo.expression, chain);
+				}
+				else
+					chain.push_back({&op});
+
+				if (ex->binaryOperation)
+					chain.push_back({nullptr, ex->binaryOperation->get().operation});
+			}
+		}
+
+		// Precedence climbing, an error is only reported where it appears
+		Value evaluate(const Chain& chain, size_t& pos, int minPrecedence, bool report) const
+		{
+			auto left = evaluateUnary(chain, pos, report);
+			while (pos < chain.size())
+			{
+				const auto operation = chain[pos].operation;
+				const auto prec = precedence(operation);
+				if (prec < minPrecedence)
+					break;
+
+				++pos;
+				auto right = evaluate(chain, pos, isRightAssociative(operation) ? prec : prec + 1, report);
+				auto result = getBinaryOperationType(operation, left.type, right.type);
+				if (report && result.type == Type::error && isDefinite(left.type) && isDefinite(right.type))
+				{
+					addDiagnostic(DiagnosticType::invalidOperation, left.begin, right.end,
+								  "Invalid operation '" + std::string{operationText(operation)} + "' between " + left.type.typeName() + " and " + right.type.typeName());
+				}
+				left = {std::move(result), left.begin, right.end};
+			}
+			return left;
+		}
+
+		Value evaluateUnary(const Chain& chain, size_t& pos, bool report) const
+		{
+			if (pos >= chain.size())
+				return {};
+
+			const auto& item = chain[pos++];
+			if (item.operand)
+				return {operandType(*item.operand), item.operand->begin, item.operand->end + 1};
+
+			auto value = evaluate(chain, pos, unaryPrecedence, report);
+			auto result = getUnaryOperationType(item.operation, value.type);
+			if (report && result.type == Type::error && isDefinite(value.type))
+			{
+				addDiagnostic(DiagnosticType::invalidOperation, item.begin, value.end,
+							  "Invalid operation '" + std::string{operationText(item.operation)} + "' on " + value.type.typeName());
+			}
+			return {std::move(result), item.begin, value.end};
+		}
+
+		// The expressions between parentheses also have their own priorities, they are checked when visiting them
+		TypeInfo operandType(const ast::Operand& op) const
+		{
+			if (op.get().type() == typeid(ast::f_PrefixExpression))
+			{
+				const auto& pe = boost::get<ast::f_PrefixExpression>(op.get()).get();
+				if (pe.rest.empty() && pe.start.get().type() == typeid(ast::BracketedExpression))
+				{
+					Chain chain;
+					flatten(boost::get<ast::BracketedExpression>(pe.start).expression, chain);
+					size_t pos = 0;
+					return evaluate(chain, pos, 0, false).type;
+				}
+			}
+			return getType(m_scope, op);
+		}
+
+		void addDiagnostic(DiagnosticType type, size_t begin, size_t end, std::string message) const
+		{
+			m_engine.m_diagnostics.push_back({type, begin, end, std::move(message)});
+		}
+
+		void childBlock(const ast::Block& block, const ast::Expression* condition = nullptr) const
+		{
+			const auto it = m_engine.m_scopes.find(&block);
+			const Visitor visitor{m_engine, m_text, it != m_engine.m_scopes.end() ? *it->second.scope : m_scope, m_nested};
+			visitor(block);
+			if (condition)
+				visitor(*condition);
+		}
+
+		TypeRef resolve(TypeRef type) const
+		{
+			const auto& info = type.get();
+			if (info.type == Type::userdata || !info.className.empty())
+				return m_scope.resolve(info);
+			return type;
+		}
+
+		TypeRef start(const boost::spirit::x3::variant<ast::BracketedExpression, std::string>& start, std::string& name) const
+		{
+			if (start.get().type() == typeid(std::string))
+			{
+				name = boost::get<std::string>(start);
+				const auto var = m_scope.findVariable(name);
+				if (var && *var)
+					return resolve(var);
+				return resolve(m_scope.getUserType(name));
+			}
+
+			const auto& be = boost::get<ast::BracketedExpression>(start);
+			(*this)(be.expression);
+			return resolve(getType(m_scope, be.expression));
+		}
+
+		TypeRef index(const TypeRef& type, std::string& name, const ast::TableIndexName& tin) const
+		{
+			if (!name.empty())
+				name += "." + tin.name;
+
+			const auto& members = type.get().members;
+			const auto it = members.find(tin.name);
+			if (it == members.end())
+				return TypeInfo{};
+			return resolve(type.part(it->second));
+		}
+
+		TypeRef index(const TypeRef& type, std::string& name, const ast::TableIndexExpression& tie) const
+		{
+			(*this)(tie.expression);
+			name.clear();
+			if (type.get().type == Type::array && getType(m_scope, tie.expression).type == Type::number)
+				return resolve(TypeInfo::fromTypeName(type.get().name));
+			return TypeInfo{Type::unknown};
+		}
+
+		TypeRef variablePostfix(const TypeRef& type, std::string& name, const ast::VariablePostfix& vp) const
+		{
+			const auto& vpType = vp.get().type();
+			if (vpType == typeid(ast::TableIndexName))
+				return index(type, name, boost::get<ast::TableIndexName>(vp));
+			if (vpType == typeid(ast::TableIndexExpression))
+				return index(type, name, boost::get<ast::TableIndexExpression>(vp));
+
+			const auto& vfc = boost::get<ast::f_VariableFunctionCall>(vp).get();
+			return variablePostfix(call(type, name, vfc.functionCall, true), name, vfc.postVariable);
+		}
+
+		// Check the function called with these arguments, and return its result if it is used
+		TypeRef call(const TypeRef& parent, std::string& name, const ast::FunctionCallEnd& fce, bool useResult) const
+		{
+			boost::apply_visitor(*this, fce.arguments);
+
+			auto function = parent;
+			if (fce.member)
+			{
+				std::string memberName = name;
+				function = index(parent, memberName, ast::TableIndexName{*fce.member});
+				if (!name.empty())
+					name += ":" + *fce.member;
+			}
+
+			const auto& info = function.get().function;
+			checkCall(function.get(), name, fce);
+			name.clear(); // We do not name the results
+
+			if (!useResult)
+				return TypeInfo{Type::unknown};
+			if (info.getResultTypeFunc)
+				return resolve(info.getResultTypeFunc(m_scope, fce.arguments, parent.get()));
+			if (!info.results.empty())
+				return resolve(function.part(info.results.front()));
+			return TypeInfo{Type::unknown};
+		}
+
+		void checkCall(const TypeInfo& function, const std::string& name, const ast::FunctionCallEnd& fce) const
+		{
+			const auto called = name.empty() ? std::string{"this value"} : "'" + name + "'";
+			if (function.type != Type::function)
+			{
+				// Tables can have a __call metamethod
+				if (isDefinite(function))
+					addDiagnostic(DiagnosticType::notAFunction, fce.begin, fce.end, "Cannot call " + called + ", it is a " + function.typeName());
+				return;
+			}
+
+			if (function.function.isVariadic)
+				return;
+
+			size_t nbArguments = 0;
+			bool multipleValues = false;
+			const auto& args = fce.arguments.get();
+			if (args.type() == typeid(ast::ExpressionsList))
+			{
+				const auto& expressions = boost::get<ast::ExpressionsList>(args);
+				nbArguments = expressions.size();
+				multipleValues = !expressions.empty() && hasMultipleValues(expressions.back());
+			}
+			else if (args.type() != typeid(ast::EmptyArguments))
+				nbArguments = 1;
+
+			// Missing arguments are nil, which is often expected, so only report the extra ones.
+			// The method calls add or remove the self parameter.
+			const size_t selfArgument = fce.member ? 1 : 0;
+			const size_t selfParameter = function.isMethod() ? 1 : 0;
+			const auto given = nbArguments + selfArgument - (multipleValues ? 1 : 0);
+			const auto expected = function.function.parameters.size() + selfParameter;
+			if (given > expected)
+			{
+				const auto nbExpected = expected >= selfArgument ? expected - selfArgument : 0;
+				addDiagnostic(DiagnosticType::argumentsCount, fce.begin, fce.end,
+							  "Too many arguments for " + called + ": " + std::to_string(nbExpected) + " expected but " + std::to_string(nbArguments) + " given");
+			}
+		}
+
+		DiagnosticsEngine& m_engine;
+		std::string_view m_text;
+		const Scope& m_scope;
+		std::vector<size_t>* m_nested; // Of the function being visited
+	};
+
+	const Diagnostics& DiagnosticsEngine::update(const Scope& rootScope, std::string_view text, const ReferenceIndex& references)
+	{
+		m_diagnostics.clear();
+		m_visitedFunctions = 0;
+		m_previousUnits = std::move(m_units);
+		m_units.clear();
+
+		// Globals used but never assigned
+		for (const auto& symbol : references.symbols())
+		{
+			if (symbol.scope != &rootScope
+				|| symbol.definition
+				|| isStandardGlobal(symbol.name)
+				|| rootScope.getVariableType(symbol.name).type != Type::nil
+				|| rootScope.getUserType(symbol.name).type != Type::nil)
+				continue;
+
+			for (const auto& use : symbol.uses)
+				m_diagnostics.push_back({DiagnosticType::undefinedVariable, use.begin, use.end, "Undefined variable '" + symbol.name + "'"});
+		}
+
+		m_scopes.clear();
+		addScopes(rootScope, 0);
+		if (rootScope.block())
+			Visitor{*this, text, rootScope}(*rootScope.block());
+
+		m_scopes.clear();
+		m_previousUnits.clear(); // The functions that were not found anymore
+
+		std::stable_sort(m_diagnostics.begin(), m_diagnostics.end(), [](const Diagnostic& lhs, const Diagnostic& rhs) {
+			return lhs.begin < rhs.begin;
+		});
+		return m_diagnostics;
+	}
+
+	const Diagnostics& DiagnosticsEngine::diagnostics() const
+	{
+		return m_diagnostics;
+	}
+
+	void DiagnosticsEngine::clear()
+	{
+		m_diagnostics.clear();
+		m_units.clear();
+		m_visitedFunctions = 0;
+	}
+
+	size_t DiagnosticsEngine::visitedFunctions() const
+	{
+		return m_visitedFunctions;
+	}
+
+	void DiagnosticsEngine::addScopes(const Scope& scope, size_t environment)
+	{
+		m_scopes[scope.block()] = {&scope, environment};
+
+		for (const auto& [name, type] : scope.variables())
+		{
+			boost::hash_combine(environment, name);
+			boost::hash_combine(environment, hashType(type));
+		}
+
+		for (const auto& child : scope.children())
+			addScopes(child, environment);
+	}
+
+	const DiagnosticsEngine::Unit* DiagnosticsEngine::reuseUnit(size_t key, std::string_view text, size_t environment)
+	{
+		// The hash is not trusted alone, a collision would give the diagnostics of another function
+		const auto matches = [text, environment](const Unit& unit) {
+			return unit.environment == environment && unit.text == text;
+		};
+
+		const auto it = m_units.find(key);
+		if (it != m_units.end())
+			return matches(it->second) ? &it->second : nullptr; // The same function is declared multiple times
+
+		const auto previous = m_previousUnits.find(key);
+		if (previous == m_previousUnits.end() || !matches(previous->second))
+			return nullptr;
+
+		return &keepUnit(previous);
+	}
+
+	DiagnosticsEngine::Unit& DiagnosticsEngine::keepUnit(std::unordered_map<size_t, Unit>::iterator previous)
+	{
+		const auto key = previous->first;
+		auto& unit = m_units.emplace(key, std::move(previous->second)).first->second;
+		m_previousUnits.erase(previous);
+
+		// Keep the functions declared inside it, for when it changes
+		for (const auto nested : unit.nested)
+		{
+			const auto it = m_previousUnits.find(nested);
+			if (it != m_previousUnits.end())
+				keepUnit(it);
+		}
+		return unit;
+	}
+} // namespace lac::an
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <lac/analysis/type_info.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lac::ast
+{
+	struct Block;
+}
+
+namespace lac::an
+{
+	class ReferenceIndex;
+
+	enum class DiagnosticType
+	{
+		undefinedVariable,
+		notAFunction,
+		argumentsCount,
+		invalidOperation
+	};
+
+	// Semantic error found in an analysed program
+	struct CORE_API Diagnostic
+	{
+		DiagnosticType type = DiagnosticType::undefinedVariable;
+		size_t begin = 0, end = 0; // Range in the text, end excluded
+		std::string message;
+	};
+	using Diagnostics = std::vector<Diagnostic>;
+
+	// Check the analysed program after each edit.
+	// The results of a function are kept while its text and the variables visible from it do not change,
+	// so only the modified functions are visited again.
+	class CORE_API DiagnosticsEngine
+	{
+	public:
+		// The scope and the references must have been created from this text, the AST having its positions
+		const Diagnostics& update(const Scope& rootScope, std::string_view text, const ReferenceIndex& references);
+		const Diagnostics& diagnostics() const; // Sorted by position
+		void clear();                           // Forget the previous results, if the user-defined types change
+
+		size_t visitedFunctions() const; // During the last update, the other ones came from the cache
+
+	private:
+		class Visitor;
+
+		struct ScopeInfo
+		{
+			const Scope* scope = nullptr;
+			size_t environment = 0; // Hash of the variables of the parent scopes
+		};
+
+		struct Unit
+		{
+			Diagnostics diagnostics;    // Relative to the beginning of the function body, nested functions included
+			std::vector<size_t> nested; // Keys of the functions declared directly inside it
+			std::string text;           // Parameters and body, compared with the environment when the key is found
+			size_t environment = 0;
+		};
+
+		void addScopes(const Scope& scope, size_t environment);
+		const Unit* reuseUnit(size_t key, std::string_view text, size_t environment);
+		Unit& keepUnit(std::unordered_map<size_t, Unit>::iterator previous);
+
+		Diagnostics m_diagnostics;
+		std::unordered_map<const ast::Block*, ScopeInfo> m_scopes;
+		std::unordered_map<size_t, Unit> m_units, m_previousUnits; // By hash of the text and the environment of the function
+		size_t m_visitedFunctions = 0;
+	};
+} // namespace lac::an
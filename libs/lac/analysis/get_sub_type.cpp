@@ -30,18 +30,25 @@ namespace lac::an
 
 		TypeInfo operator()(const ast::TableIndexName& tin) const
 		{
+			if (const auto variable = findParentVariable())
+				return variable->member(tin.name);
 			return parentAsVariable().member(tin.name);
 		}
 
 		TypeInfo operator()(const ast::FunctionCallEnd& fce) const
 		{
-			const auto parent = parentAsVariable();
+			const auto variable = findParentVariable();
+			const auto parent = variable ? TypeInfo{} : parentAsVariable();
+			const auto& parentRef = variable ? *variable : parent;
 			const auto type = fce.member
-								  ? parent.member(*fce.member)
-								  : parent;
+								  ? parentRef.member(*fce.member)
+								  : parentRef;
+
+			if (!fce.member && type.type != Type::function && m_parentType.name == "setmetatable")
+				return setMetatable(fce.arguments);
 
 			if (type.function.getResultTypeFunc)
-				return type.function.getResultTypeFunc(m_scope, fce.arguments, parent);
+				return type.function.getResultTypeFunc(m_scope, fce.arguments, parentRef);
 
 			if (type.function.results.empty())
 				return {};
@@ -60,6 +67,45 @@ namespace lac::an
 		}
 
 	private:
+		// The object, with the class being the table used by the __index field of the metatable
+		TypeInfo setMetatable(const ast::Arguments& args) const
+		{
+			if (args.get().type() != typeid(ast::ExpressionsList))
+				return {};
+			const auto& expressions = boost::get<ast::ExpressionsList>(args.get());
+			if (expressions.empty())
+				return {};
+
+			auto object = getType(m_scope, expressions.front());
+			if (object.type != Type::table || expressions.size() < 2)
+				return object;
+
+			const auto metatable = getType(m_scope, expressions[1]);
+			const auto it = metatable.members.find("__index");
+			if (it == metatable.members.end() || it->second.type != Type::table)
+				return object;
+
+			const auto& index = it->second;
+			if (!index.className.empty())
+				object.className = index.className;
+			object.members.insert(index.members.begin(), index.members.end()); // If the table is not a variable
+			return object;
+		}
+
+		// The variable named by the parent type, if it can be used without copying it (when it is not a user-defined type or a class instance)
+		const TypeInfo* findParentVariable() const
+		{
+			if (m_parentType.type != Type::unknown || m_parentType.name.empty())
+				return nullptr;
+
+			const auto info = m_scope.findVariable(m_parentType.name);
+			if (!info || !*info || info->type == Type::userdata)
+				return nullptr;
+			if (!info->className.empty())
+				return nullptr; // Instance of a class, must be resolved
+			return info;
+		}
+
 		TypeInfo parentAsVariable() const
 		{
 			if (m_parentType.type == Type::unknown && !m_parentType.name.empty())
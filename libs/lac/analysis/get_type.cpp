@@ -3,6 +3,34 @@
 #include <lac/analysis/scope.h>
 #include <lac/parser/ast.h>
 
+#include <algorithm>
+
+namespace
+{
+	bool isFunctionCall(const lac::ast::Operand& o)
+	{
+		if (o.get().type() != typeid(lac::ast::f_PrefixExpression))
+			return false;
+
+		const auto& rest = boost::get<lac::ast::f_PrefixExpression>(o.get()).get().rest;
+		return std::any_of(rest.begin(), rest.end(), [](const lac::ast::PostPrefix& pp) {
+			return pp.get().type() == typeid(lac::ast::FunctionCallEnd);
+		});
+	}
+
+	// The name of the variable, if the expression is only a variable
+	const std::string* getVariableName(const lac::ast::Expression& e)
+	{
+		if (e.binaryOperation || e.operand.get().type() != typeid(lac::ast::f_PrefixExpression))
+			return nullptr;
+
+		const auto& pe = boost::get<lac::ast::f_PrefixExpression>(e.operand.get()).get();
+		if (!pe.rest.empty() || pe.start.get().type() != typeid(std::string))
+			return nullptr;
+		return &boost::get<std::string>(pe.start.get());
+	}
+} // namespace
+
 namespace lac::an
 {
 	class GetType : public boost::static_visitor<TypeInfo>
@@ -10,6 +38,7 @@ namespace lac::an
 	public:
 		GetType(const Scope& scope)
 			: m_scope(scope)
+			, m_cache(scope.getTypeCache())
 		{
 		}
 
@@ -52,26 +81,7 @@ namespace lac::an
 
 		TypeInfo operator()(const ast::UnaryOperation& uo) const
 		{
-			const auto right = (*this)(uo.expression);
-
-			using OP = ast::Operation;
-			switch (uo.operation)
-			{
-			case OP::unm:
-			case OP::bnot:
-				return right.convert(Type::number);
-
-			case OP::len:
-				return (right.type == Type::string || right.type == Type::table)
-						   ? Type::number
-						   : Type::error;
-
-			case OP::lnot:
-				return Type::boolean;
-
-			default:
-				return Type::error;
-			}
+			return getUnaryOperationType(uo.operation, (*this)(uo.expression));
 		}
 
 		TypeInfo operator()(const ast::TableConstructor& tc) const
@@ -87,7 +97,9 @@ namespace lac::an
 				if (fieldType == typeid(ast::FieldByAssignment))
 				{
 					const auto& assignment = boost::get<ast::FieldByAssignment>(field.get());
-					info.members[assignment.name] = getType(m_scope, assignment.value);
+					info.members[assignment.name] = assignment.name == "__index"
+														? getIndexType(m_scope, assignment.value)
+														: getType(m_scope, assignment.value);
 				}
 				else if (fieldType == typeid(ast::Expression))
 				{
@@ -104,6 +116,7 @@ namespace lac::an
 		TypeInfo operator()(const ast::FunctionBody& fb) const
 		{
 			TypeInfo info{Type::function};
+			info.function.isVariadic = fb.parameters && fb.parameters->varargs;
 			if (fb.parameters && !fb.parameters->parameters.empty())
 			{
 				const auto& params = fb.parameters->parameters;
@@ -117,7 +130,7 @@ namespace lac::an
 				for (size_t nb = params.size(); i<nb; ++i)
 					info.function.parameters.emplace_back(params[i]);
 			}
-			// TODO: fill the function results
+			// The results are added by analyseBlock, after the analysis of the body
 			return info;
 		}
 
@@ -148,9 +161,22 @@ namespace lac::an
 			return type;
 		}
 
+		TypeInfo operator()(const ast::Operand& o) const
+		{
+			if (!m_cache || !isFunctionCall(o))
+				return boost::apply_visitor(*this, o);
+
+			if (const auto type = m_cache->find(o))
+				return *type;
+
+			auto type = boost::apply_visitor(*this, o);
+			m_cache->add(o, type);
+			return type;
+		}
+
 		TypeInfo operator()(const ast::Expression& e) const
 		{
-			const auto first = boost::apply_visitor(*this, e.operand);
+			const auto first = (*this)(e.operand);
 			if (!e.binaryOperation)
 				return first;
 
@@ -161,73 +187,54 @@ namespace lac::an
 		{
 			// TODO: we cannot correctly support left associative operations
 			//  (must rework the parser)
+			return getBinaryOperationType(bo.operation, left, (*this)(bo.expression));
+		}
 
-			const auto operand = (*this)(bo.expression);
+	private:
+		const Scope& m_scope;
+		ExpressionTypeCache* m_cache = nullptr;
+	};
 
-			auto convertAll = [&](Type type) {
-				if (left.convert(type) && operand.convert(type))
-					return type;
-				return Type::error;
-			};
+	const TypeInfo* ExpressionTypeCache::find(const ast::Operand& o)
+	{
+		const auto it = m_types.find(&o);
+		if (it == m_types.end())
+		{
+			++m_misses;
+			return nullptr;
+		}
 
-			auto allType = [&](Type type) {
-				return left.type == type && operand.type == type;
-			};
+		++m_hits;
+		return &it->second;
+	}
 
-			using OP = ast::Operation;
-			switch (bo.operation)
-			{
-			case OP::add:
-			case OP::sub:
-			case OP::mul:
-			case OP::div:
-			case OP::idiv:
-			case OP::mod:
-				return convertAll(Type::number);
-
-			case OP::pow: // Right associative
-				return convertAll(Type::number);
-
-			case OP::band:
-			case OP::bor:
-			case OP::bxor:
-			case OP::bnot:
-			case OP::shl:
-			case OP::shr:
-				return convertAll(Type::number);
-
-			case OP::concat: // Right associative
-				return convertAll(Type::string);
-
-			case OP::lt:
-			case OP::le:
-			case OP::gt:
-			case OP::ge:
-				if (allType(Type::number) || allType(Type::string))
-					return Type::boolean;
-				return Type::error;
+	void ExpressionTypeCache::add(const ast::Operand& o, TypeInfo type)
+	{
+		m_types[&o] = std::move(type);
+	}
 
-			case OP::eq:
-			case OP::ineq:
-				return Type::boolean;
+	void ExpressionTypeCache::clear()
+	{
+		m_types.clear();
+		m_hits = m_misses = 0;
+	}
 
-			case OP::land:
-			case OP::lor:
-				// TODO: create a variant type
-				if (!left && !operand)
-					return Type::error;
-				if (left.type == operand.type)
-					return left;
-				return Type::unknown;
+	size_t ExpressionTypeCache::size() const
+	{
+		return m_types.size();
+	}
 
-			default:
-				return Type::error;
-			}
-		}
+	size_t ExpressionTypeCache::hits() const
+	{
+		return m_hits;
+	}
 
-	private:
-		const Scope& m_scope;
-	};
+	size_t ExpressionTypeCache::misses() const
+	{
+		return m_misses;
+	}
+
+	/****************************************************************************/
 
 	TypeInfo getType(const Scope& scope, const ast::Expression& e)
 	{
@@ -238,4 +245,109 @@ namespace lac::an
 	{
 		return GetType{scope}(f);
 	}
+
+	TypeInfo getType(const Scope& scope, const ast::Operand& o)
+	{
+		return GetType{scope}(o);
+	}
+
+	TypeInfo getIndexType(const Scope& scope, const ast::Expression& e)
+	{
+		const auto name = getVariableName(e);
+		if (!name)
+			return getType(scope, e);
+
+		const auto variable = scope.findVariable(*name);
+		if (!variable || variable->type != Type::table)
+			return getType(scope, e);
+
+		TypeInfo type = Type::table;
+		type.className = *name;
+		return type;
+	}
+
+	TypeInfo getUnaryOperationType(ast::Operation operation, const TypeInfo& operand)
+	{
+		using OP = ast::Operation;
+		switch (operation)
+		{
+		case OP::unm:
+		case OP::bnot:
+			return operand.convert(Type::number);
+
+		case OP::len:
+			return (operand.type == Type::string || operand.type == Type::table)
+					   ? Type::number
+					   : Type::error;
+
+		case OP::lnot:
+			return Type::boolean;
+
+		default:
+			return Type::error;
+		}
+	}
+
+	TypeInfo getBinaryOperationType(ast::Operation operation, const TypeInfo& left, const TypeInfo& right)
+	{
+		auto convertAll = [&](Type type) {
+			if (left.convert(type) && right.convert(type))
+				return type;
+			return Type::error;
+		};
+
+		auto allType = [&](Type type) {
+			return left.type == type && right.type == type;
+		};
+
+		using OP = ast::Operation;
+		switch (operation)
+		{
+		case OP::add:
+		case OP::sub:
+		case OP::mul:
+		case OP::div:
+		case OP::idiv:
+		case OP::mod:
+			return convertAll(Type::number);
+
+		case OP::pow: // Right associative
+			return convertAll(Type::number);
+
+		case OP::band:
+		case OP::bor:
+		case OP::bxor:
+		case OP::bnot:
+		case OP::shl:
+		case OP::shr:
+			return convertAll(Type::number);
+
+		case OP::concat: // Right associative
+			return convertAll(Type::string);
+
+		case OP::lt:
+		case OP::le:
+		case OP::gt:
+		case OP::ge:
+			if (allType(Type::number) || allType(Type::string))
+				return Type::boolean;
+			return Type::error;
+
+		case OP::eq:
+		case OP::ineq:
+			return Type::boolean;
+
+		case OP::land:
+		case OP::lor:
+			// TODO: create a variant type
+			if (!left && !right)
+				return Type::error;
+			if (left.type == right.type)
+				return left;
+			return Type::unknown;
+
+		default:
+			return Type::error;
+		}
+	}
 } // namespace lac::an
@@ -2,16 +2,49 @@
 
 #include <lac/analysis/type_info.h>
 
+#include <unordered_map>
+
 namespace lac::ast
 {
 	struct Expression;
 	struct FunctionBody;
+	struct Operand;
+	enum class Operation;
 }
 
 namespace lac::an
 {
 	class Scope;
 
+	// Types of the function calls of an analysed program, so that each one is evaluated only once per analysis
+	// (the results can be given by callbacks). The other expressions are cheaper to evaluate than to store.
+	// The nodes are identified by their address, the cache must be cleared when the AST changes.
+	class CORE_API ExpressionTypeCache
+	{
+	public:
+		const TypeInfo* find(const ast::Operand& o); // Counts a hit or a miss
+		void add(const ast::Operand& o, TypeInfo type);
+		void clear(); // For a new analysis, also resets the counters
+
+		size_t size() const;
+		size_t hits() const;
+		size_t misses() const;
+
+	private:
+		std::unordered_map<const ast::Operand*, TypeInfo> m_types;
+		size_t m_hits = 0, m_misses = 0;
+	};
+
+	// Use the cache of the scope if set (see Scope::setTypeCache)
 	TypeInfo getType(const Scope& scope, const ast::Expression& e);
 	TypeInfo getType(const Scope& scope, const ast::FunctionBody& f);
+	TypeInfo getType(const Scope& scope, const ast::Operand& o);
+
+	// Type of a value assigned to a __index field: a table having this class if the expression is only a table
+	// variable, so that the members of the class are found when needed instead of being copied (see Scope::resolve)
+	TypeInfo getIndexType(const Scope& scope, const ast::Expression& e);
+
+	// Type of the result of an operation, error if the operands cannot be converted
+	TypeInfo getUnaryOperationType(ast::Operation operation, const TypeInfo& operand);
+	TypeInfo getBinaryOperationType(ast::Operation operation, const TypeInfo& left, const TypeInfo& right);
 } // namespace lac::an
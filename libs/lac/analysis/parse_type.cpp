@@ -10,6 +10,11 @@
 
 #include <doctest/doctest.h>
 
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
 namespace lac::type::ast
 {
 	struct NamedType
@@ -297,35 +302,119 @@ namespace lac::an
 		return info;
 	}
 
-	bool setFunction(FunctionInfo& info, std::string_view view)
+	std::optional<FunctionInfo> parseFunction(std::string_view view)
 	{
 		auto f = view.begin();
 		const auto l = view.end();
 		type::ast::FunctionType func;
 		if (!boost::spirit::x3::phrase_parse(f, l, type::parser::function, boost::spirit::x3::ascii::space, func) || f != l)
-			return false;
+			return {};
 
-		info = createFunction(func);
-		return true;
+		return createFunction(func);
 	}
 
-	bool setType(TypeInfo& info, std::string_view view)
+	std::optional<TypeInfo> parseType(std::string_view view)
 	{
 		auto f = view.begin();
 		const auto l = view.end();
 		type::ast::ParsedType type;
 		if (!boost::spirit::x3::phrase_parse(f, l, type::parser::parsedType, boost::spirit::x3::ascii::space, type) || f != l)
-			return false;
+			return {};
 
 		if (type.get().type() == typeid(type::ast::NamedType))
-			info = createType(boost::get<type::ast::NamedType>(type));
-		else
+			return createType(boost::get<type::ast::NamedType>(type));
+
+		TypeInfo info{Type::function};
+		info.function = createFunction(boost::get<type::ast::FunctionType>(type));
+		return info;
+	}
+
+	// Result of the parsing of each signature, as the same texts are used again and again when registering an API.
+	// Failures are also kept. The stored values have no callbacks, they are only copied.
+	template <class T>
+	class SignatureCache
+	{
+	public:
+		using ParseFunc = std::optional<T> (*)(std::string_view);
+
+		SignatureCache(ParseFunc func)
+			: m_parseFunc(func)
+		{
+		}
+
+		bool get(T& info, std::string_view view)
+		{
+			std::string text{view};
+			{
+				std::shared_lock lock{m_mutex};
+				const auto it = m_cache.find(text);
+				if (it != m_cache.end())
+					return assign(info, it->second);
+			}
+
+			auto result = m_parseFunc(view); // Parsing outside of the lock, another thread may do the same work
+			std::unique_lock lock{m_mutex};
+			const auto it = m_cache.try_emplace(std::move(text), std::move(result)).first;
+			return assign(info, it->second);
+		}
+
+		size_t size() const
+		{
+			std::shared_lock lock{m_mutex};
+			return m_cache.size();
+		}
+
+		void clear()
+		{
+			std::unique_lock lock{m_mutex};
+			m_cache.clear();
+		}
+
+	private:
+		static bool assign(T& info, const std::optional<T>& result)
 		{
-			info.type = Type::function;
-			info.function = createFunction(boost::get<type::ast::FunctionType>(type));
+			if (!result)
+				return false;
+			info = *result;
+			return true;
 		}
 
-		return true;
+		ParseFunc m_parseFunc;
+		mutable std::shared_mutex m_mutex;
+		std::unordered_map<std::string, std::optional<T>> m_cache;
+	};
+
+	SignatureCache<FunctionInfo>& functionCache()
+	{
+		static SignatureCache<FunctionInfo> cache{parseFunction};
+		return cache;
+	}
+
+	SignatureCache<TypeInfo>& typeCache()
+	{
+		static SignatureCache<TypeInfo> cache{parseType};
+		return cache;
+	}
+
+	bool setFunction(FunctionInfo& info, std::string_view view)
+	{
+		return functionCache().get(info, view);
+	}
+
+	bool setType(TypeInfo& info, std::string_view view)
+	{
+		return typeCache().get(info, view);
+	}
+
+	size_t signatureCacheSize()
+	{
+		return functionCache().size() + typeCache().size();
+	}
+
+	void clearSignatureCache()
+	{
+		functionCache().clear();
+		typeCache().clear();
 	}
 
 	TEST_CASE("FunctionInfo from text")
@@ -423,4 +512,36 @@ namespace lac::an
 		CHECK(info.type == Type::function);
 		CHECK(info.function.getResultTypeFunc);
 	}
+
+	TEST_CASE("Signature cache")
+	{
+		clearSignatureCache();
+		CHECK(signatureCacheSize() == 0);
+
+		const auto first = TypeInfo{"number function(string text)"};
+		const auto second = TypeInfo{"number function(string text)"};
+		CHECK(signatureCacheSize() == 1);
+		CHECK(first.type == second.type);
+		REQUIRE(second.function.parameters.size() == 1);
+		CHECK(second.function.parameters[0].name() == "text");
+
+		// The callbacks are not shared between the instances
+		auto dummyFunc = [](const an::Scope&, const ast::Arguments&, const an::TypeInfo&) {
+			return TypeInfo(Type::number);
+		};
+		const auto withCallback = TypeInfo{"number function(string text)", dummyFunc};
+		CHECK(withCallback.function.getResultTypeFunc);
+		CHECK_FALSE(TypeInfo{"number function(string text)"}.function.getResultTypeFunc);
+		CHECK(signatureCacheSize() == 1);
+
+		// Functions are parsed with a different grammar
+		const auto func = FunctionInfo{"number function(string text)"};
+		CHECK(func.parameters.size() == 1);
+		CHECK(signatureCacheSize() == 2);
+
+		// Failures are kept too
+		CHECK(TypeInfo{"function("}.type == Type::error);
+		CHECK(TypeInfo{"function("}.type == Type::error);
+		CHECK(signatureCacheSize() == 3);
+	}
 } // namespace lac::an
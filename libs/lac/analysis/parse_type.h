@@ -1,5 +1,7 @@
 #pragma once
 
+#include <lac/core_api.h>
+
 #include <string_view>
 
 namespace lac::an
@@ -9,4 +11,8 @@ namespace lac::an
 
 	bool setFunction(FunctionInfo& info, std::string_view view);
 	bool setType(TypeInfo& info, std::string_view view);
+
+	// The results of setFunction and setType are cached, these are mostly for tests
+	CORE_API size_t signatureCacheSize();
+	CORE_API void clearSignatureCache();
 } // namespace lac::an
@@ -0,0 +1,528 @@
+#include <lac/analysis/references.h>
+#include <lac/analysis/scope.h>
+#include <lac/parser/ast_adapted.h>
+#include <lac/parser/lexer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+namespace
+{
+	using lac::an::Scope;
+	using lac::an::Symbols;
+	using lac::ast::ElementType;
+	using lac::parser::Token;
+
+	constexpr auto npos = std::string_view::npos;
+
+	bool isNameChar(char c)
+	{
+		return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+	}
+
+	// Follow the tokens in order, keeping the stack of the scopes containing the current one
+	class IndexBuilder
+	{
+	public:
+		IndexBuilder(const Scope& rootScope, std::string_view text)
+			: m_rootScope(rootScope)
+			, m_text(text)
+			, m_tokens(lac::parser::lexText(text))
+		{
+			addScopes(rootScope);
+
+			// Parents before their children
+			std::stable_sort(m_scopes.begin(), m_scopes.end(), [](const ScopeRange& lhs, const ScopeRange& rhs) {
+				return lhs.begin < rhs.begin || (lhs.begin == rhs.begin && lhs.end > rhs.end);
+			});
+			m_pending.resize(m_scopes.size());
+
+			std::sort(m_localStatements.begin(), m_localStatements.end(), [](const Range& lhs, const Range& rhs) {
+				return lhs.begin < rhs.begin;
+			});
+		}
+
+		Symbols build()
+		{
+			size_t previousEnd = 0;
+			for (size_t i = 0; i < m_tokens.size(); ++i)
+			{
+				const auto& token = m_tokens[i];
+				updateBrackets(previousEnd, token.begin);
+				previousEnd = token.end;
+				showDelayed(token.begin);
+				enterScopes(token.begin);
+
+				if (token.type == ElementType::keyword)
+					keyword(i);
+				else if (token.type == ElementType::variable)
+					name(token);
+				else if (token.type != ElementType::comment)
+					m_mode = Mode::none;
+			}
+
+			return std::move(m_symbols);
+		}
+
+	private:
+		enum class Mode
+		{
+			none,
+			local,         // After "local"
+			localFunction, // After "local function"
+			functionName,  // After "function"
+			loop,          // After "for"
+			label          // After "goto"
+		};
+
+		struct Range
+		{
+			size_t begin = 0, end = 0; // End is not included
+		};
+
+		struct ScopeRange
+		{
+			size_t begin = 0, end = 0; // End is not included
+			const Scope* scope = nullptr;
+		};
+
+		struct Frame
+		{
+			size_t end = 0;
+			const Scope* scope = nullptr;
+			std::vector<std::string_view> names; // Local variables visible until the end of the scope
+		};
+
+		// Local variable only visible after the end of its statement
+		struct Delayed
+		{
+			size_t visibleAt = 0;
+			size_t symbol = 0;
+			std::string_view name;
+			size_t frame = 0; // Number of frames when it was declared
+		};
+
+		// Parameters of the last function, declared in the scope of its body
+		struct FunctionHeader
+		{
+			size_t open = 0, close = 0; // Positions of the parentheses
+			size_t scope = 0;
+		};
+
+		void addScopes(const Scope& scope)
+		{
+			if (const auto block = scope.block())
+			{
+				m_scopes.push_back({block->begin, block->end + 1, &scope});
+				for (const auto& statement : block->statements)
+					addLocalStatement(statement);
+			}
+			for (const auto& child : scope.children())
+				addScopes(child);
+		}
+
+		// Range of the expressions of a local assignment, they cannot see the variables it declares
+		void addLocalStatement(const lac::ast::Statement& statement)
+		{
+			const auto local = boost::get<lac::ast::LocalAssignmentStatement>(&statement.get());
+			if (!local || !local->expressions || local->expressions->empty())
+				return;
+
+			const auto* last = &local->expressions->back();
+			while (last->binaryOperation)
+				last = &last->binaryOperation->get().expression;
+			m_localStatements.push_back({local->expressions->front().operand.begin, last->operand.end + 1});
+		}
+
+		// Index of the first scope beginning after the position, the one of the body following a header
+		size_t scopeAfter(size_t pos) const
+		{
+			const auto it = std::upper_bound(m_scopes.begin(), m_scopes.end(), pos, [](size_t p, const ScopeRange& range) {
+				return p < range.begin;
+			});
+			return it - m_scopes.begin();
+		}
+
+		void enterScopes(size_t pos)
+		{
+			for (;;)
+			{
+				while (!m_frames.empty() && m_frames.back().end <= pos)
+					leaveScope();
+
+				if (m_nextScope >= m_scopes.size() || m_scopes[m_nextScope].begin > pos)
+					break;
+
+				const auto index = m_nextScope++;
+				m_frames.push_back({m_scopes[index].end, m_scopes[index].scope, {}});
+				for (const auto& pending : m_pending[index])
+					makeVisible(pending.first, pending.second);
+			}
+		}
+
+		void leaveScope()
+		{
+			auto& names = m_frames.back().names;
+			for (auto it = names.rbegin(); it != names.rend(); ++it)
+				m_locals[*it].pop_back();
+			m_frames.pop_back();
+		}
+
+		void updateBrackets(size_t begin, size_t end)
+		{
+			// Only punctuation and whitespace between two tokens
+			for (auto i = begin; i < end && i < m_text.size(); ++i)
+			{
+				const auto c = m_text[i];
+				if (c == '(' || c == '[' || c == '{')
+					m_brackets.push_back(c);
+				else if ((c == ')' || c == ']' || c == '}') && !m_brackets.empty())
+					m_brackets.pop_back();
+			}
+		}
+
+		std::string_view text(const Token& token) const
+		{
+			return m_text.substr(token.begin, token.end - token.begin);
+		}
+
+		size_t previousIndex(size_t pos) const
+		{
+			while (pos != 0 && std::isspace(static_cast<unsigned char>(m_text[pos - 1])))
+				--pos;
+			return pos ? pos - 1 : npos;
+		}
+
+		size_t nextIndex(size_t pos) const
+		{
+			while (pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[pos])))
+				++pos;
+			return pos < m_text.size() ? pos : npos;
+		}
+
+		char charAt(size_t pos) const
+		{
+			return pos < m_text.size() ? m_text[pos] : 0;
+		}
+
+		bool isAssignmentOperator(size_t pos) const
+		{
+			return charAt(pos) == '=' && charAt(pos + 1) != '=';
+		}
+
+		void keyword(size_t index)
+		{
+			const auto& token = m_tokens[index];
+			const auto word = text(token);
+			if (word == "local")
+				m_mode = Mode::local;
+			else if (word == "function")
+			{
+				m_mode = m_mode == Mode::local ? Mode::localFunction : Mode::functionName;
+				startFunction(token);
+			}
+			else if (word == "for")
+			{
+				m_mode = Mode::loop;
+				m_loopScope = m_scopes.size();
+				for (auto i = index + 1; i < m_tokens.size(); ++i)
+				{
+					if (m_tokens[i].type == ElementType::keyword && text(m_tokens[i]) == "do")
+					{
+						m_loopScope = scopeAfter(m_tokens[i].begin);
+						break;
+					}
+				}
+			}
+			else if (word == "goto")
+				m_mode = Mode::label;
+			else
+				m_mode = Mode::none;
+		}
+
+		void startFunction(const Token& token)
+		{
+			m_function.reset();
+			const auto open = m_text.find('(', token.end);
+			const auto close = open != npos ? m_text.find(')', open) : npos;
+			if (close == npos)
+				return;
+
+			m_function = FunctionHeader{open, close, scopeAfter(close)};
+
+			// The methods have an implicit parameter
+			if (m_text.substr(token.end, open - token.end).find(':') != npos)
+				declareInScope(m_function->scope, "self", nullptr, ElementType::variable);
+		}
+
+		void name(const Token& token)
+		{
+			const auto mode = m_mode;
+			const auto previous = previousIndex(token.begin);
+			const auto before = previous != npos ? m_text[previous] : 0;
+			const auto beforePrevious = previous != npos ? charAt(previous - 1) : 0;
+
+			// Members of a table, labels and keys of a table constructor are not symbols
+			if ((before == '.' && beforePrevious != '.') || (before == ':' && beforePrevious != ':'))
+				return;
+
+			m_mode = Mode::none;
+			const auto next = nextIndex(token.end);
+			if (mode == Mode::label || (before == ':' && beforePrevious == ':'))
+				return;
+			if (!m_brackets.empty() && m_brackets.back() == '{'
+				&& (before == '{' || before == ',' || before == ';')
+				&& isAssignmentOperator(next))
+				return;
+
+			const auto name = text(token);
+			if (m_function && token.begin > m_function->open && token.begin < m_function->close)
+			{
+				declareInScope(m_function->scope, name, &token, ElementType::variable);
+				return;
+			}
+
+			switch (mode)
+			{
+			case Mode::local:
+				declare(name, token, ElementType::variable, localStatementEnd(token.end));
+				if (charAt(next) == ',')
+					m_mode = Mode::local;
+				return;
+
+			case Mode::localFunction:
+				declare(name, token, ElementType::function);
+				return;
+
+			case Mode::loop:
+				declareInScope(m_loopScope, name, &token, ElementType::variable);
+				if (charAt(next) == ',')
+					m_mode = Mode::loop;
+				return;
+
+			case Mode::functionName:
+			{
+				// Either the function itself, or the table containing it
+				const auto isTable = charAt(next) == '.' || charAt(next) == ':';
+				use(token, isTable ? ElementType::variable : ElementType::function, !isTable);
+				return;
+			}
+
+			default:
+			{
+				const auto c = charAt(next);
+				const auto isCall = c == '(' || c == '"' || c == '\'' || c == '{';
+				use(token, isCall ? ElementType::function : ElementType::variable, isAssignment(next));
+				return;
+			}
+			}
+		}
+
+		// Test if the name is followed by "=", or by other names then "="
+		bool isAssignment(size_t next) const
+		{
+			if (!m_brackets.empty() && m_brackets.back() == '{')
+				return false;
+
+			while (charAt(next) == ',')
+			{
+				next = nextIndex(next + 1);
+				if (next == npos || !isNameChar(m_text[next]))
+					return false;
+				while (next < m_text.size() && isNameChar(m_text[next]))
+					++next;
+				next = nextIndex(next);
+			}
+
+			return next != npos && isAssignmentOperator(next);
+		}
+
+		lac::pos::Element element(const Token& token, ElementType type) const
+		{
+			lac::pos::Element elt{type};
+			elt.begin = token.begin;
+			elt.end = token.end;
+			return elt;
+		}
+
+		lac::an::Symbol createSymbol(std::string_view name, const Scope* scope, const Token* token, ElementType type, bool local = true) const
+		{
+			lac::an::Symbol symbol;
+			symbol.name = name;
+			symbol.scope = scope;
+			symbol.local = local;
+			if (token)
+			{
+				symbol.definition = element(*token, type);
+				symbol.uses.push_back(*symbol.definition);
+			}
+			return symbol;
+		}
+
+		// End of the local assignment statement declaring a variable ending at this position, 0 without expressions
+		size_t localStatementEnd(size_t pos) const
+		{
+			const auto it = std::lower_bound(m_localStatements.begin(), m_localStatements.end(), pos, [](const Range& range, size_t p) {
+				return range.begin < p;
+			});
+			if (it == m_localStatements.end())
+				return 0;
+
+			// Only the other names of the statement can be between the variable and its expressions
+			auto next = nextIndex(pos);
+			while (next < it->begin && m_text[next] == ',')
+			{
+				next = nextIndex(next + 1);
+				while (next < it->begin && isNameChar(m_text[next]))
+					++next;
+				next = nextIndex(next);
+			}
+			return next < it->begin && isAssignmentOperator(next)
+					   ? it->end
+					   : 0;
+		}
+
+		// Declare a local variable in the current scope, visible from the given position (immediately if 0)
+		void declare(std::string_view name, const Token& token, ElementType type, size_t visibleAt = 0)
+		{
+			const auto scope = m_frames.empty() ? &m_rootScope : m_frames.back().scope;
+			m_symbols.push_back(createSymbol(name, scope, &token, type));
+			if (visibleAt)
+				m_delayed.push_back({visibleAt, m_symbols.size() - 1, name, m_frames.size()});
+			else
+				makeVisible(m_symbols.size() - 1, name);
+		}
+
+		// The locals whose statement ended before this position
+		void showDelayed(size_t pos)
+		{
+			const auto it = std::stable_partition(m_delayed.begin(), m_delayed.end(), [pos](const Delayed& delayed) {
+				return delayed.visibleAt > pos;
+			});
+			for (auto d = it; d != m_delayed.end(); ++d)
+			{
+				m_locals[d->name].push_back(d->symbol);
+				if (d->frame)
+					m_frames[d->frame - 1].names.push_back(d->name);
+			}
+			m_delayed.erase(it, m_delayed.end());
+		}
+
+		// Declare a local variable in a scope that will be entered later (parameters and loop variables)
+		void declareInScope(size_t index, std::string_view name, const Token* token, ElementType type)
+		{
+			const auto scope = index < m_scopes.size() ? m_scopes[index].scope : nullptr;
+			m_symbols.push_back(createSymbol(name, scope, token, type));
+			if (index < m_pending.size())
+				m_pending[index].push_back({m_symbols.size() - 1, name});
+		}
+
+		// The name must not be the one of the symbol, as the symbols can be moved
+		void makeVisible(size_t id, std::string_view name)
+		{
+			m_locals[name].push_back(id);
+			if (!m_frames.empty())
+				m_frames.back().names.push_back(name);
+		}
+
+		void use(const Token& token, ElementType type, bool assignment)
+		{
+			const auto name = text(token);
+			size_t id = 0;
+			const auto localIt = m_locals.find(name);
+			if (localIt != m_locals.end() && !localIt->second.empty())
+				id = localIt->second.back();
+			else
+			{
+				const auto globalIt = m_globals.find(name);
+				if (globalIt != m_globals.end())
+					id = globalIt->second;
+				else
+				{
+					id = m_symbols.size();
+					m_symbols.push_back(createSymbol(name, &m_rootScope, nullptr, type, false));
+					m_globals[name] = id;
+				}
+
+				if (assignment && !m_symbols[id].definition)
+					m_symbols[id].definition = element(token, type);
+			}
+
+			m_symbols[id].uses.push_back(element(token, type));
+		}
+
+		const Scope& m_rootScope;
+		std::string_view m_text;
+		lac::parser::Tokens m_tokens;
+
+		std::vector<ScopeRange> m_scopes;
+		std::vector<Range> m_localStatements; // Sorted by position
+		std::vector<Delayed> m_delayed;       // Locals waiting for the end of their statement
+		std::vector<std::vector<std::pair<size_t, std::string_view>>> m_pending; // For each scope, the symbols declared before entering it
+		size_t m_nextScope = 0;
+		std::vector<Frame> m_frames;
+		std::string m_brackets;
+
+		Mode m_mode = Mode::none;
+		boost::optional<FunctionHeader> m_function;
+		size_t m_loopScope = 0;
+
+		Symbols m_symbols;
+		std::unordered_map<std::string_view, std::vector<size_t>> m_locals; // Stack of the visible declarations by name
+		std::unordered_map<std::string_view, size_t> m_globals;
+	};
+} // namespace
+
+namespace lac::an
+{
+	ReferenceIndex::ReferenceIndex(const Scope& rootScope, std::string_view text)
+		: m_symbols(IndexBuilder{rootScope, text}.build())
+	{
+		for (size_t i = 0; i < m_symbols.size(); ++i)
+		{
+			for (const auto& use : m_symbols[i].uses)
+				m_occurrences.push_back({use.begin, use.end, i});
+		}
+
+		std::sort(m_occurrences.begin(), m_occurrences.end(), [](const Occurrence& lhs, const Occurrence& rhs) {
+			return lhs.begin < rhs.begin;
+		});
+	}
+
+	const Symbols& ReferenceIndex::symbols() const
+	{
+		return m_symbols;
+	}
+
+	const Symbol* ReferenceIndex::symbolAtPos(size_t pos) const
+	{
+		// The last occurrence starting before the position, the cursor can also be just after the name
+		auto it = std::upper_bound(m_occurrences.begin(), m_occurrences.end(), pos, [](size_t p, const Occurrence& occ) {
+			return p < occ.begin;
+		});
+		if (it == m_occurrences.begin())
+			return nullptr;
+
+		--it;
+		return pos <= it->end
+				   ? &m_symbols[it->symbol]
+				   : nullptr;
+	}
+
+	boost::optional<pos::Element> ReferenceIndex::getDefinitionAtPos(size_t pos) const
+	{
+		const auto symbol = symbolAtPos(pos);
+		return symbol
+				   ? symbol->definition
+				   : boost::none;
+	}
+
+	pos::Elements ReferenceIndex::getReferencesAtPos(size_t pos) const
+	{
+		const auto symbol = symbolAtPos(pos);
+		return symbol
+				   ? symbol->uses
+				   : pos::Elements{};
+	}
+} // namespace lac::an
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <lac/parser/positions.h>
+
+#include <boost/optional.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lac::an
+{
+	class Scope;
+
+	struct CORE_API Symbol
+	{
+		std::string name;
+		const Scope* scope = nullptr;             // Scope declaring the local variable, the root scope for the globals
+		boost::optional<pos::Element> definition; // Declaration of a local, first assignment of a global
+		pos::Elements uses;                       // Every occurrence of the name (definition included), sorted by position
+		bool local = false;                       // Declared with local, or a parameter or a loop variable
+	};
+	using Symbols = std::vector<Symbol>;
+
+	// Where the names of a program are defined and used, for find-references and go-to-definition.
+	// The names are found by the lexer, and the scopes of the analysis give the visibility of the local variables.
+	class CORE_API ReferenceIndex
+	{
+	public:
+		ReferenceIndex() = default;
+		ReferenceIndex(const Scope& rootScope, std::string_view text); // The scope must have been analysed from this text
+
+		const Symbols& symbols() const;
+		const Symbol* symbolAtPos(size_t pos) const;
+
+		boost::optional<pos::Element> getDefinitionAtPos(size_t pos) const;
+		pos::Elements getReferencesAtPos(size_t pos) const;
+
+	private:
+		struct Occurrence
+		{
+			size_t begin = 0, end = 0;
+			size_t symbol = 0;
+		};
+
+		Symbols m_symbols;
+		std::vector<Occurrence> m_occurrences; // Sorted by position
+	};
+} // namespace lac::an
@@ -0,0 +1,327 @@
+#include <lac/analysis/analyze_block.h>
+#include <lac/analysis/result_type_cache.h>
+#include <lac/analysis/scope.h>
+#include <lac/analysis/user_defined.h>
+#include <lac/helper/arguments.h>
+#include <lac/parser/parser.h>
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+	void appendString(std::string& key, const std::string& str)
+	{
+		key += std::to_string(str.size());
+		key += ':';
+		key += str;
+	}
+
+	// Returns false if an argument is not a literal
+	bool appendArguments(std::string& key, const lac::ast::Arguments& args)
+	{
+		using namespace lac;
+		const auto& var = args.get();
+		if (var.type() == typeid(ast::EmptyArguments))
+			return true;
+		if (var.type() == typeid(ast::LiteralString))
+		{
+			key += 's';
+			appendString(key, boost::get<ast::LiteralString>(var).value);
+			return true;
+		}
+		if (var.type() != typeid(ast::ExpressionsList))
+			return false; // Table constructor
+
+		const auto& expList = boost::get<ast::ExpressionsList>(var);
+		for (size_t i = 0; i < expList.size(); ++i)
+		{
+			if (expList[i].binaryOperation)
+				return false;
+
+			if (const auto str = helper::getLiteralString(args, i))
+			{
+				key += 's';
+				appendString(key, *str);
+			}
+			else if (const auto num = helper::getNumeral(args, i))
+			{
+				if (num->isInt())
+					key += 'i' + std::to_string(num->asInt());
+				else
+				{
+					const auto value = num->asFloat();
+					key += 'f';
+					key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+				}
+			}
+			else if (expList[i].operand.get().type() == typeid(ast::ExpressionConstant))
+			{
+				const auto constant = boost::get<ast::ExpressionConstant>(expList[i].operand.get());
+				if (constant == ast::ExpressionConstant::dots)
+					return false;
+				key += 'c' + std::to_string(static_cast<int>(constant));
+			}
+			else
+				return false;
+		}
+		return true;
+	}
+
+	// Returns false if the parent has custom data, that cannot be compared
+	bool appendParent(std::string& key, const lac::an::TypeInfo& parent)
+	{
+		if (parent.custom.has_value())
+			return false;
+
+		key += 't' + std::to_string(static_cast<int>(parent.type));
+		appendString(key, parent.name);
+		for (const auto& member : parent.members)
+		{
+			appendString(key, member.first);
+			key += 'h' + std::to_string(lac::an::hashType(member.second)); // The callback can use the types of the members
+		}
+		return true;
+	}
+} // namespace
+
+namespace lac::an
+{
+	struct ResultTypeCache::State
+	{
+		std::mutex mutex; // The wrapped callbacks can be shared by analyses running in other threads
+		std::unordered_map<size_t, std::unordered_map<std::string, TypeInfo>> results; // By callback, then by arguments and parent
+		size_t nextId = 0, size = 0, hits = 0, misses = 0;
+	};
+
+	struct ResultTypeCache::Callback
+	{
+		TypeInfo operator()(const Scope& scope, const ast::Arguments& args, const TypeInfo& parent) const
+		{
+			std::string key;
+			if (!appendArguments(key, args) || !appendParent(key, parent))
+				return func(scope, args, parent);
+
+			{
+				std::lock_guard lock{state->mutex};
+				auto& results = state->results[id];
+				const auto it = results.find(key);
+				if (it != results.end())
+				{
+					++state->hits;
+					return it->second;
+				}
+				++state->misses;
+			}
+
+			// Not locked, the callback can call other wrapped callbacks
+			auto type = func(scope, args, parent);
+
+			std::lock_guard lock{state->mutex};
+			if (state->results[id].emplace(std::move(key), type).second)
+				++state->size;
+			return type;
+		}
+
+		FunctionInfo::GetResultType func;
+		std::shared_ptr<State> state;
+		size_t id = 0;
+	};
+
+	ResultTypeCache::ResultTypeCache()
+		: m_state(std::make_shared<State>())
+	{
+	}
+
+	FunctionInfo::GetResultType ResultTypeCache::wrap(FunctionInfo::GetResultType func)
+	{
+		if (!func)
+			return {};
+
+		const auto callback = func.target<Callback>();
+		if (callback && callback->state == m_state)
+			return func; // Already wrapped
+
+		std::lock_guard lock{m_state->mutex};
+		return Callback{std::move(func), m_state, m_state->nextId++};
+	}
+
+	void ResultTypeCache::wrapAll(UserDefined& userDefined)
+	{
+		for (auto* map : {&userDefined.variables, &userDefined.scriptEntries, &userDefined.types})
+		{
+			for (auto& it : *map)
+				wrapAll(it.second);
+		}
+	}
+
+	void ResultTypeCache::wrapAll(TypeInfo& type)
+	{
+		if (type.function.getResultTypeFunc)
+			type.function.getResultTypeFunc = wrap(std::move(type.function.getResultTypeFunc));
+
+		for (auto& member : type.members)
+			wrapAll(member.second);
+	}
+
+	void ResultTypeCache::invalidate()
+	{
+		std::lock_guard lock{m_state->mutex};
+		m_state->results.clear();
+		m_state->size = 0;
+	}
+
+	void ResultTypeCache::invalidate(const FunctionInfo& function)
+	{
+		const auto callback = function.getResultTypeFunc.target<Callback>();
+		if (!callback || callback->state != m_state)
+			return;
+
+		std::lock_guard lock{m_state->mutex};
+		const auto it = m_state->results.find(callback->id);
+		if (it == m_state->results.end())
+			return;
+
+		m_state->size -= it->second.size();
+		m_state->results.erase(it);
+	}
+
+	size_t ResultTypeCache::size() const
+	{
+		std::lock_guard lock{m_state->mutex};
+		return m_state->size;
+	}
+
+	size_t ResultTypeCache::hits() const
+	{
+		std::lock_guard lock{m_state->mutex};
+		return m_state->hits;
+	}
+
+	size_t ResultTypeCache::misses() const
+	{
+		std::lock_guard lock{m_state->mutex};
+		return m_state->misses;
+	}
+
+	TEST_CASE("Result type cache")
+	{
+		size_t nbCreate = 0, nbLength = 0;
+		auto create = [&nbCreate](const Scope&, const ast::Arguments& args, const TypeInfo&) -> TypeInfo {
+			++nbCreate;
+			const auto str = helper::getLiteralString(args);
+			if (str && *str == "number")
+				return Type::number;
+			return Type::string;
+		};
+		auto length = [&nbLength](const Scope&, const ast::Arguments&, const TypeInfo& parent) -> TypeInfo {
+			++nbLength;
+			return parent.name == "Vector" ? Type::number : Type::unknown;
+		};
+
+		UserDefined userDefined;
+		userDefined.addVariable("create", TypeInfo::createFunction({{"type", Type::string}}, {}, create));
+		TypeInfo vector = Type::table;
+		vector.name = "Vector";
+		vector.members["length"] = TypeInfo::createMethod({}, {}, length);
+		userDefined.addType(vector);
+		userDefined.addVariable("v", TypeInfo::fromTypeName("Vector"));
+
+		ResultTypeCache cache;
+		cache.wrapAll(userDefined);
+		cache.wrapAll(userDefined); // No double wrapping
+
+		Scope parentScope;
+		parentScope.setUserDefined(&userDefined);
+
+		auto analyse = [&parentScope](const std::string& program) {
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+			return analyseBlock(ret.block, &parentScope);
+		};
+
+		const std::string program = "local a = create('number')\nlocal b = create(\"string\", 2)\nlocal c = v:length()";
+		auto scope = analyse(program);
+		CHECK(scope.getVariableType("a").type == Type::number);
+		CHECK(scope.getVariableType("b").type == Type::string);
+		CHECK(scope.getVariableType("c").type == Type::number);
+		CHECK(nbCreate == 2);
+		CHECK(nbLength == 1);
+		CHECK(cache.size() == 3);
+		CHECK(cache.misses() == 3);
+
+		// Same program after an edit, the callbacks are not called again
+		scope = analyse(program + "\nlocal d = create('number')");
+		CHECK(scope.getVariableType("d").type == Type::number);
+		CHECK(nbCreate == 2);
+		CHECK(nbLength == 1);
+		CHECK(cache.hits() == 4);
+		CHECK(cache.size() == 3);
+
+		// Arguments that are not literals are always forwarded
+		scope = analyse("local t = 'number'\nlocal a = create(t)\nlocal b = create('num' .. 'ber')\nlocal c = create({})");
+		CHECK(nbCreate == 5);
+		CHECK(cache.size() == 3);
+
+		// Invalidation of one callback
+		cache.invalidate(userDefined.variables["create"].function);
+		CHECK(cache.size() == 1);
+		analyse(program);
+		CHECK(nbCreate == 7);
+		CHECK(nbLength == 1);
+
+		// Invalidation of all the callbacks
+		cache.invalidate();
+		CHECK(cache.size() == 0);
+		analyse(program);
+		CHECK(nbCreate == 9);
+		CHECK(nbLength == 2);
+
+		// A wrapped callback can outlive the cache
+		auto standalone = ResultTypeCache{}.wrap(create);
+		ast::LiteralString str;
+		str.value = "number";
+		ast::Expression exp;
+		exp.operand = str;
+		ast::Arguments args;
+		args = ast::ExpressionsList{exp};
+		CHECK(standalone(parentScope, args, {}).type == Type::number);
+		CHECK(standalone(parentScope, args, {}).type == Type::number);
+		CHECK(nbCreate == 10);
+
+		// The parents having members of other types give other results
+		TypeInfo parent = Type::table;
+		parent.members["x"] = Type::number;
+		standalone(parentScope, args, parent);
+		standalone(parentScope, args, parent);
+		CHECK(nbCreate == 11);
+		parent.members["x"] = Type::string;
+		standalone(parentScope, args, parent);
+		CHECK(nbCreate == 12);
+
+		// Used by several threads
+		std::atomic<int> nbConcurrent = 0;
+		ResultTypeCache shared;
+		const auto concurrent = shared.wrap([&nbConcurrent](const Scope&, const ast::Arguments&, const TypeInfo&) -> TypeInfo {
+			++nbConcurrent;
+			return Type::number;
+		});
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&] {
+				for (int j = 0; j < 100; ++j)
+					concurrent(parentScope, args, {});
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		CHECK(shared.size() == 1);
+		CHECK(shared.hits() + shared.misses() == 400);
+		CHECK(nbConcurrent == static_cast<int>(shared.misses()));
+	}
+} // namespace lac::an
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <lac/analysis/type_info.h>
+
+#include <memory>
+
+namespace lac::an
+{
+	class UserDefined;
+
+	// Opt-in memoization of the FunctionInfo::GetResultType callbacks.
+	// A wrapped callback is called only once for the same function, literal arguments and parent type.
+	// The calls having other arguments (variables, expressions, tables) are always forwarded, as their type depends on the scope.
+	// The results are shared under a lock, a wrapped UserDefined can be used by analyses in several threads.
+	class CORE_API ResultTypeCache
+	{
+	public:
+		ResultTypeCache();
+
+		// The returned callback shares the results of the cache, and can outlive it
+		FunctionInfo::GetResultType wrap(FunctionInfo::GetResultType func);
+		void wrapAll(UserDefined& userDefined); // The callbacks of the variables, the script inputs and the members of the types
+		void wrapAll(TypeInfo& type);           // The callback of this function, or the ones of the members of this table
+
+		void invalidate();                             // Forget all the results, when the data used by the callbacks changed
+		void invalidate(const FunctionInfo& function); // Only the results of the callback of this function, if wrapped by this cache
+
+		size_t size() const; // Number of results kept
+		size_t hits() const;
+		size_t misses() const;
+
+	private:
+		struct State;
+		struct Callback;
+
+		std::shared_ptr<State> m_state;
+	};
+} // namespace lac::an
@@ -24,6 +24,7 @@ namespace lac::an
 			}
 		}
 		m_variables[name] = std::move(type);
+		m_classShapes.clear();
 	}
 
 	TypeInfo Scope::getVariableType(const std::string& name) const
@@ -41,8 +42,24 @@ namespace lac::an
 		return Type::nil;
 	}
 
+	const TypeInfo* Scope::findVariable(const std::string& name) const
+	{
+		const auto it = m_variables.find(name);
+		if (it != m_variables.end())
+			return &it->second;
+		if (m_userDefined)
+		{
+			if (auto var = m_userDefined->getVariable(name))
+				return var;
+		}
+		if (m_parent)
+			return m_parent->findVariable(name);
+		return nullptr;
+	}
+
 	TypeInfo& Scope::modifyTable(const std::string& name)
 	{
+		m_classShapes.clear();
 		const auto it = m_variables.find(name);
 		if (it != m_variables.end())
 			return it->second;
@@ -85,9 +102,24 @@ namespace lac::an
 				   : *this;
 	}
 
-	void Scope::addChildScope(Scope&& scope)
+	const Scope* Scope::parent() const
+	{
+		return m_parent;
+	}
+
+	Scope& Scope::addChildScope(Scope&& scope)
 	{
-		m_children.push_back(std::move(scope));
+		return m_children.emplace_back(std::move(scope));
+	}
+
+	void Scope::reset()
+	{
+		m_children.clear();
+		m_variables.clear();
+		m_labels.clear();
+		m_results.clear();
+		m_classShapes.clear();
+		m_pendingFunction = nullptr;
 	}
 
 	void Scope::setUserDefined(UserDefined* userDefined)
@@ -102,6 +134,18 @@ namespace lac::an
 				   : m_userDefined;
 	}
 
+	void Scope::setTypeCache(ExpressionTypeCache* cache)
+	{
+		getGlobalScope().m_typeCache = cache;
+	}
+
+	ExpressionTypeCache* Scope::getTypeCache() const
+	{
+		return m_parent
+				   ? m_parent->getTypeCache()
+				   : m_typeCache;
+	}
+
 	TypeInfo Scope::resolve(const TypeInfo& type) const
 	{
 		if (type.type == Type::userdata)
@@ -112,9 +156,68 @@ namespace lac::an
 				out.custom = type.custom;
 			return out;
 		}
+
+		if (type.type == Type::table && !type.className.empty())
+		{
+			const auto shape = getClassShape(type.className);
+			if (!shape || shape->members.empty())
+				return type;
+
+			auto out = type;
+			out.members.insert(shape->members.begin(), shape->members.end()); // Does not replace the members of the instance
+			return out;
+		}
 		return type;
 	}
 
+	const TypeInfo* Scope::getClassShape(const std::string& name) const
+	{
+		std::set<std::string> visited;
+		return findClassShape(name, visited);
+	}
+
+	const TypeInfo* Scope::findClassShape(const std::string& name, std::set<std::string>& visited) const
+	{
+		// Find the scope declaring this variable
+		const Scope* scope = this;
+		const TypeInfo* variable = nullptr;
+		for (; scope; scope = scope->m_parent)
+		{
+			const auto it = scope->m_variables.find(name);
+			if (it != scope->m_variables.end())
+				variable = &it->second;
+			else if (scope->m_userDefined)
+				variable = scope->m_userDefined->getVariable(name);
+			if (variable)
+				break;
+		}
+		if (!variable || variable->type != Type::table)
+			return nullptr;
+
+		auto& shapes = scope->m_classShapes;
+		const auto it = shapes.find(name);
+		if (it != shapes.end())
+			return &it->second;
+
+		if (!visited.insert(name).second)
+			return nullptr; // The chain loops
+
+		auto shape = *variable;
+		if (!shape.className.empty())
+		{
+			if (const auto base = scope->findClassShape(shape.className, visited))
+				shape.members.insert(base->members.begin(), base->members.end());
+		}
+		return &shapes.emplace(name, std::move(shape)).first->second;
+	}
+
+	void Scope::clearClassShapes()
+	{
+		m_classShapes.clear();
+		for (auto& child : m_children)
+			child.clearClassShapes();
+	}
+
 	const ast::Block* Scope::block() const
 	{
 		return m_block;
@@ -131,6 +234,43 @@ namespace lac::an
 		return m_children;
 	}
 
+	std::vector<Scope>& Scope::modifyChildren()
+	{
+		children(); // Fix the parent pointers
+		return m_children;
+	}
+
+	const std::map<std::string, TypeInfo>& Scope::variables() const
+	{
+		return m_variables;
+	}
+
+	void Scope::setResults(std::vector<TypeInfo> results)
+	{
+		m_results = std::move(results);
+	}
+
+	const std::vector<TypeInfo>& Scope::results() const
+	{
+		return m_results;
+	}
+
+	void Scope::setPendingFunction(const ast::FunctionBody* function, std::string name)
+	{
+		m_pendingFunction = function;
+		m_pendingFunctionName = std::move(name);
+	}
+
+	const ast::FunctionBody* Scope::pendingFunction() const
+	{
+		return m_pendingFunction;
+	}
+
+	const std::string& Scope::pendingFunctionName() const
+	{
+		return m_pendingFunctionName;
+	}
+
 	std::map<std::string, Element> Scope::getElements(bool localOnly) const
 	{
 		std::map<std::string, Element> elements;
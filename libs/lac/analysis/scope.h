@@ -11,10 +11,12 @@
 namespace lac::ast
 {
 	struct Block;
+	struct FunctionBody;
 }
 
 namespace lac::an
 {
+	class ExpressionTypeCache;
 	class UserDefined;
 
 	enum class ElementType
@@ -32,7 +34,7 @@ namespace lac::an
 	};
 	using ElementsMap = std::map<std::string, Element>;
 
-	class Scope
+	class CORE_API Scope
 	{
 	public:
 		Scope() = default;
@@ -40,6 +42,7 @@ namespace lac::an
 
 		void addVariable(const std::string& name, TypeInfo type);
 		TypeInfo getVariableType(const std::string& name) const;
+		const TypeInfo* findVariable(const std::string& name) const; // Same as getVariableType without copying the type, null if not found
 
 		TypeInfo& modifyTable(const std::string& name);
 
@@ -49,25 +52,55 @@ namespace lac::an
 		TypeInfo getUserType(std::string_view name) const;
 
 		Scope& getGlobalScope();
-		void addChildScope(Scope&& scope);
+		const Scope* parent() const;
+		Scope& addChildScope(Scope&& scope);
+		void reset(); // Remove the variables, the labels and the children, to analyse the block again
 
 		void setUserDefined(UserDefined* userDefined);
 		const UserDefined* getUserDefined() const;
-		TypeInfo resolve(const TypeInfo& type) const; // If the given type is userdata, return the corresponding table, else no change
+		// If the given type is userdata, return the corresponding table.
+		// If it is an instance of a class (see TypeInfo::className), add the members of the class it does not define.
+		TypeInfo resolve(const TypeInfo& type) const;
+
+		// Members of the table variable with this name, and of the tables in its __index chain (the class of a table
+		// is the variable used as its __index, see setmetatable in getType). Computed once, then cached.
+		// Null if the variable is not a table.
+		const TypeInfo* getClassShape(const std::string& name) const;
+		void clearClassShapes(); // Of this scope and its children, the shapes computed during the analysis can be incomplete
+
+		void setTypeCache(ExpressionTypeCache* cache); // Used by getType for this scope and its children
+		ExpressionTypeCache* getTypeCache() const;
 
 		const ast::Block* block() const;
 		const std::vector<Scope>& children() const;
+		std::vector<Scope>& modifyChildren();
+		const std::map<std::string, TypeInfo>& variables() const; // Only the ones of this scope
+
+		void setResults(std::vector<TypeInfo> results); // Types returned by the function of this scope
+		const std::vector<TypeInfo>& results() const;
+
+		// The function of this scope, if its body has not been analysed yet (see analyseBlockLazy)
+		void setPendingFunction(const ast::FunctionBody* function, std::string name = {});
+		const ast::FunctionBody* pendingFunction() const;
+		const std::string& pendingFunctionName() const;
 
 		ElementsMap getElements(bool localOnly = true) const;
 
 	private:
+		const TypeInfo* findClassShape(const std::string& name, std::set<std::string>& visited) const;
+
 		const ast::Block* m_block = nullptr;
 		Scope* m_parent = nullptr;
 		UserDefined* m_userDefined = nullptr;
+		ExpressionTypeCache* m_typeCache = nullptr;
 
 		std::vector<Scope> m_children;
 		std::map<std::string, TypeInfo> m_variables;
 		std::set<std::string> m_labels;
+		std::vector<TypeInfo> m_results;
+		mutable std::map<std::string, TypeInfo> m_classShapes; // For the variables of this scope
+		const ast::FunctionBody* m_pendingFunction = nullptr;
+		std::string m_pendingFunctionName;
 	};
 
 	ElementsMap getElements(const TypeInfo& type);
@@ -1,8 +1,11 @@
 #include <lac/analysis/type_info.h>
 #include <lac/analysis/parse_type.h>
 
+#include <boost/container_hash/hash.hpp>
 #include <doctest/doctest.h>
 
+#include <limits>
+
 namespace lac::an
 {
 	VariableInfo::VariableInfo(const VariableInfo& other)
@@ -284,6 +287,38 @@ namespace lac::an
 		return str;
 	}
 
+	size_t hashType(const TypeInfo& type)
+	{
+		return hashType(type, std::numeric_limits<size_t>::max());
+	}
+
+	size_t hashType(const TypeInfo& type, size_t maxDepth)
+	{
+		size_t hash = static_cast<size_t>(type.type);
+		boost::hash_combine(hash, type.name);
+		boost::hash_combine(hash, type.className);
+		if (type.type == Type::function)
+		{
+			boost::hash_combine(hash, type.function.isMethod);
+			boost::hash_combine(hash, type.function.isVariadic);
+			for (const auto& param : type.function.parameters)
+			{
+				boost::hash_combine(hash, param.name());
+				boost::hash_combine(hash, hashType(param.type(), maxDepth));
+			}
+			for (const auto& result : type.function.results)
+				boost::hash_combine(hash, hashType(result, maxDepth));
+		}
+
+		for (const auto& [name, member] : type.members)
+		{
+			boost::hash_combine(hash, name);
+			if (maxDepth)
+				boost::hash_combine(hash, hashType(member, maxDepth - 1));
+		}
+		return hash;
+	}
+
 	TEST_CASE("Text construction")
 	{
 		CHECK(TypeInfo{"number"}.type == Type::number);
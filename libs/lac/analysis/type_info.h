@@ -71,6 +71,7 @@ namespace lac::an
 		std::vector<VariableInfo> parameters;
 		std::vector<TypeInfo> results;
 		bool isMethod = false;
+		bool isVariadic = false; // The parameters end with "..."
 		GetResultType getResultTypeFunc;
 		GetCompletion getCompletionFunc;
 	};
@@ -102,6 +103,7 @@ namespace lac::an
 
 		// For tables
 		std::map<std::string, TypeInfo> members;
+		std::string className; // Table variable used as the __index of its metatable, whose members it inherits (see Scope::resolve)
 		bool hasMember(const std::string& name) const;
 		TypeInfo member(const std::string& name) const;
 
@@ -119,4 +121,7 @@ namespace lac::an
 
 		std::string description; // For documentation purposes
 	};
+
+	CORE_API size_t hashType(const TypeInfo& type); // Of the type, name, signature and members, ignoring the callbacks and the custom data
+	CORE_API size_t hashType(const TypeInfo& type, size_t maxDepth); // Same, but only the names of the members below this depth
 } // namespace lac::an
@@ -3,6 +3,13 @@
 #include <doctest/doctest.h>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
 namespace lac::an
 {
 	void UserDefined::addVariable(std::string_view name, TypeInfo type)
@@ -93,27 +100,325 @@ namespace lac::an
 		return j;
 	}
 
-	void UserDefined::addFromJson(const std::string& str)
+	// Builds the types directly from the parser events, without creating the whole json document.
+	// Only the type being read (and its parents) are kept in memory.
+	class UserDefinedSax
+	{
+	public:
+		using json = nlohmann::json;
+
+		UserDefinedSax(UserDefined& userDefined)
+			: m_userDefined(userDefined)
+		{
+		}
+
+		bool null() { return scalar(); }
+		bool boolean(bool) { return scalar(); }
+		bool number_integer(json::number_integer_t) { return scalar(); }
+		bool number_unsigned(json::number_unsigned_t) { return scalar(); }
+		bool number_float(json::number_float_t, const std::string&) { return scalar(); }
+		bool binary(json::binary_t&) { return scalar(); }
+
+		bool string(std::string& val)
+		{
+			switch (current())
+			{
+			case Context::types:
+			case Context::variables:
+			case Context::scriptInputs:
+			case Context::members:
+				addType(m_key, TypeInfo{val});
+				break;
+
+			case Context::type:
+			{
+				auto& frame = m_typeFrames.back();
+				if (m_key == "type")
+					frame.type = std::move(val);
+				else if (m_key == "name")
+					frame.name = std::move(val);
+				else if (m_key == "description")
+					frame.description = std::move(val);
+				break;
+			}
+
+			default:
+				break;
+			}
+			return true;
+		}
+
+		bool start_object(std::size_t)
+		{
+			if (m_contexts.empty())
+			{
+				m_contexts.push_back(Context::root);
+				return true;
+			}
+
+			switch (current())
+			{
+			case Context::root:
+				if (m_key == "variables")
+					m_contexts.push_back(Context::variables);
+				else if (m_key == "script_inputs")
+					m_contexts.push_back(Context::scriptInputs);
+				else
+					m_contexts.push_back(Context::skip);
+				break;
+
+			case Context::types:
+			case Context::variables:
+			case Context::scriptInputs:
+			case Context::members:
+				m_typeFrames.emplace_back();
+				m_typeFrames.back().key = m_key;
+				m_contexts.push_back(Context::type);
+				break;
+
+			case Context::type:
+				m_contexts.push_back(m_key == "members" ? Context::members : Context::skip);
+				break;
+
+			case Context::skip:
+			default:
+				m_contexts.push_back(Context::skip);
+				break;
+			}
+			return true;
+		}
+
+		bool end_object()
+		{
+			const auto context = current();
+			m_contexts.pop_back();
+			if (context == Context::type)
+			{
+				auto frame = std::move(m_typeFrames.back());
+				m_typeFrames.pop_back();
+
+				auto info = TypeInfo{frame.type};
+				info.name = std::move(frame.name);
+				info.description = std::move(frame.description);
+				info.members = std::move(frame.members);
+				addType(frame.key, std::move(info));
+			}
+			return true;
+		}
+
+		bool start_array(std::size_t)
+		{
+			if (!m_contexts.empty() && current() == Context::root && m_key == "types")
+				m_contexts.push_back(Context::types);
+			else if (!m_contexts.empty() && expectsType())
+				throw std::invalid_argument("Invalid definition for the type " + m_key);
+			else
+				m_contexts.push_back(Context::skip);
+			return true;
+		}
+
+		bool end_array()
+		{
+			m_contexts.pop_back();
+			return true;
+		}
+
+		bool key(std::string& val)
+		{
+			m_key = std::move(val);
+			return true;
+		}
+
+		bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex)
+		{
+			if (const auto parseError = dynamic_cast<const json::parse_error*>(&ex))
+				throw *parseError;
+			throw std::invalid_argument(ex.what());
+		}
+
+	private:
+		enum class Context
+		{
+			root,
+			types,        // Array of types
+			variables,    // Object of name -> type
+			scriptInputs, // Object of name -> type
+			type,         // Object describing a type
+			members,      // Object of name -> type, inside a type
+			skip          // Unknown value
+		};
+
+		struct TypeFrame
+		{
+			std::string key; // Name of the variable or member
+			std::string type, name, description;
+			std::map<std::string, TypeInfo> members;
+		};
+
+		Context current() const
+		{
+			return m_contexts.empty() ? Context::skip : m_contexts.back();
+		}
+
+		bool expectsType() const
+		{
+			const auto context = current();
+			return context == Context::types
+				   || context == Context::variables
+				   || context == Context::scriptInputs
+				   || context == Context::members;
+		}
+
+		bool scalar()
+		{
+			if (expectsType())
+				throw std::invalid_argument("Invalid definition for the type " + m_key);
+			return true;
+		}
+
+		void addType(const std::string& key, TypeInfo info)
+		{
+			switch (current())
+			{
+			case Context::types:
+				m_userDefined.addType(std::move(info));
+				break;
+			case Context::variables:
+				m_userDefined.addVariable(key, std::move(info));
+				break;
+			case Context::scriptInputs:
+				m_userDefined.addScriptInput(key, std::move(info));
+				break;
+			case Context::members:
+				m_typeFrames.back().members[key] = std::move(info);
+				break;
+			default:
+				break;
+			}
+		}
+
+		UserDefined& m_userDefined;
+		std::vector<Context> m_contexts;
+		std::vector<TypeFrame> m_typeFrames;
+		std::string m_key;
+	};
+
+	template <class Input>
+	UserDefined loadJson(Input&& input)
 	{
-		const auto json = nlohmann::json::parse(str);
+		UserDefined loaded;
+		UserDefinedSax sax{loaded};
+		nlohmann::json::sax_parse(std::forward<Input>(input), &sax);
+		return loaded;
+	}
 
-		if (json.contains("types"))
+	// Index of the fragment that added each definition
+	using Owners = std::map<std::string, size_t>;
+
+	void mergeMap(UserDefined::TypeMap& target, UserDefined::TypeMap& source, UserDefinedConflict::Category category,
+				  size_t index, Owners& owners, UserDefinedConflicts* conflicts)
+	{
+		for (auto& it : source)
 		{
-			for (const auto& type : json["types"])
-				addType(typeFromJson(type));
+			if (conflicts)
+			{
+				auto ownerIt = owners.find(it.first);
+				if (ownerIt != owners.end())
+				{
+					conflicts->push_back({category, it.first, ownerIt->second, index});
+					ownerIt->second = index;
+				}
+				else
+				{
+					if (target.count(it.first))
+						conflicts->push_back({category, it.first, UserDefinedConflict::existing, index});
+					owners[it.first] = index;
+				}
+			}
+
+			target[it.first] = std::move(it.second);
 		}
+	}
+
+	void merge(UserDefined& target, UserDefined& source)
+	{
+		Owners owners; // Not used without the conflicts
+		mergeMap(target.types, source.types, UserDefinedConflict::Category::type, 0, owners, nullptr);
+		mergeMap(target.variables, source.variables, UserDefinedConflict::Category::variable, 0, owners, nullptr);
+		mergeMap(target.scriptEntries, source.scriptEntries, UserDefinedConflict::Category::scriptInput, 0, owners, nullptr);
+	}
 
-		if (json.contains("variables"))
+	void UserDefined::addFromJson(const std::string& str)
+	{
+		// Loading first so that the current definitions are not modified if the input is invalid
+		auto loaded = loadJson(str);
+		merge(*this, loaded);
+	}
+
+	void UserDefined::addFromJson(std::istream& stream)
+	{
+		auto loaded = loadJson(stream);
+		merge(*this, loaded);
+	}
+
+	bool UserDefined::addFromJsonFile(const std::string& path)
+	{
+		std::ifstream in(path, std::ios_base::binary);
+		if (!in)
+			return false;
+
+		addFromJson(in);
+		return true;
+	}
+
+	UserDefinedConflicts UserDefined::addFromJsonFragments(const std::vector<std::string>& fragments, size_t nbThreads)
+	{
+		std::vector<UserDefined> loaded(fragments.size());
+		std::vector<std::exception_ptr> errors(fragments.size());
+
+		// Each thread takes the next fragment not yet loaded
+		std::atomic<size_t> next = 0;
+		auto work = [&] {
+			for (auto index = next++; index < fragments.size(); index = next++)
+			{
+				try
+				{
+					loaded[index] = loadJson(fragments[index]);
+				}
+				catch (...)
+				{
+					errors[index] = std::current_exception();
+				}
+			}
+		};
+
+		if (!nbThreads)
+			nbThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		nbThreads = std::min(nbThreads, fragments.size());
+
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < nbThreads; ++i)
+			threads.emplace_back(work);
+		work(); // The current thread also participates
+		for (auto& thread : threads)
+			thread.join();
+
+		for (const auto& error : errors)
 		{
-			for (const auto& it : json["variables"].items())
-				addVariable(it.key(), typeFromJson(it.value()));
+			if (error)
+				std::rethrow_exception(error);
 		}
 
-		if (json.contains("script_inputs"))
+		// Merge in the order of the fragments, so that the result does not depend on the threads
+		UserDefinedConflicts conflicts;
+		Owners typeOwners, variableOwners, inputOwners;
+		for (size_t i = 0; i < loaded.size(); ++i)
 		{
-			for (const auto& it : json["script_inputs"].items())
-				addScriptInput(it.key(), typeFromJson(it.value()));
+			mergeMap(types, loaded[i].types, UserDefinedConflict::Category::type, i, typeOwners, &conflicts);
+			mergeMap(variables, loaded[i].variables, UserDefinedConflict::Category::variable, i, variableOwners, &conflicts);
+			mergeMap(scriptEntries, loaded[i].scriptEntries, UserDefinedConflict::Category::scriptInput, i, inputOwners, &conflicts);
 		}
+		return conflicts;
 	}
 
 	std::string UserDefined::toJson() const
@@ -179,6 +484,120 @@ namespace lac::an
 		REQUIRE(info.members["position"].function.results.size() == 1);
 		CHECK(info.members["position"].function.results.front().name == "Pos");
 	}
+
+	TEST_CASE("UserDefined streaming json")
+	{
+		// The type is after the members, and unknown keys are skipped
+		const std::string def = R"~~(
+{
+	"version": { "major": 1, "list": [1, 2, { "a": "b" }] },
+	"types": [
+		{
+			"name": "Player",
+			"members": {
+				"id": "number",
+				"position": { "description": "In the world", "type": "Pos method()" }
+			},
+			"comment": [ "not", "a", "type" ],
+			"type": "table"
+		}
+	],
+	"variables": {
+		"player": "Player",
+		"count": { "type": "number", "description": "Number of players" }
+	},
+	"script_inputs": {
+		"onStart": "function(Player player)",
+		"notAFunction": "number"
+	}
+}
+)~~";
+
+		UserDefined userDefined;
+		std::istringstream stream{def};
+		userDefined.addFromJson(stream);
+
+		REQUIRE(userDefined.types.size() == 1);
+		const auto player = userDefined.getType("Player");
+		REQUIRE(player);
+		CHECK(player->type == Type::table);
+		REQUIRE(player->members.size() == 2);
+		CHECK(player->members.at("id").type == Type::number);
+		CHECK(player->members.at("position").type == Type::function);
+		CHECK(player->members.at("position").description == "In the world");
+		CHECK(player->members.at("position").functionDefinition() == "Pos method()");
+
+		REQUIRE(userDefined.variables.size() == 2);
+		CHECK(userDefined.getVariable("player")->name == "Player");
+		CHECK(userDefined.getVariable("count")->type == Type::number);
+		CHECK(userDefined.getVariable("count")->description == "Number of players");
+
+		REQUIRE(userDefined.scriptEntries.size() == 1);
+		CHECK(userDefined.getScriptInput("onStart")->function.parameters.size() == 1);
+
+		// Same result as the json document
+		UserDefined fromString;
+		fromString.addFromJson(def);
+		CHECK(fromString.toJson() == userDefined.toJson());
+		CHECK(nlohmann::json::parse(userDefined.toJson())["types"][0] == typeToJson(typeFromJson(nlohmann::json::parse(def)["types"][0])));
+
+		// Nothing is added if the input is invalid
+		UserDefined invalid;
+		CHECK_THROWS_AS(invalid.addFromJson(R"~~({ "variables": { "a": "number", "b": )~~"), nlohmann::json::parse_error);
+		CHECK_THROWS_AS(invalid.addFromJson(R"~~({ "variables": { "a": "number", "b": 42 } })~~"), std::invalid_argument);
+		CHECK(invalid.variables.empty());
+
+		CHECK_FALSE(invalid.addFromJsonFile("file that does not exist.json"));
+	}
+
+	TEST_CASE("UserDefined json fragments")
+	{
+		std::vector<std::string> fragments;
+		for (int i = 0; i < 20; ++i)
+		{
+			const auto index = std::to_string(i);
+			fragments.push_back(R"~~({
+	"types": [ { "type": "table", "name": "Type)~~" + index + R"~~(" } ],
+	"variables": { "var)~~" + index + R"~~(": "number", "shared": "Type)~~" + index + R"~~(" }
+})~~");
+		}
+
+		UserDefined userDefined;
+		userDefined.addVariable("var3", TypeInfo{"string"});
+		const auto conflicts = userDefined.addFromJsonFragments(fragments, 4);
+
+		CHECK(userDefined.types.size() == 20);
+		CHECK(userDefined.variables.size() == 21);
+		CHECK(userDefined.getVariable("var3")->type == Type::number);
+		CHECK(userDefined.getVariable("shared")->name == "Type19"); // The last fragment wins
+
+		// Same result with a single thread
+		UserDefined sequential;
+		sequential.addVariable("var3", TypeInfo{"string"});
+		const auto sequentialConflicts = sequential.addFromJsonFragments(fragments, 1);
+		CHECK(sequential.toJson() == userDefined.toJson());
+		CHECK(sequentialConflicts.size() == conflicts.size());
+
+		// Sorted by fragment, then by category and name
+		REQUIRE(conflicts.size() == 20);
+		CHECK(conflicts[3].category == UserDefinedConflict::Category::variable);
+		CHECK(conflicts[3].name == "var3");
+		CHECK(conflicts[3].previous == UserDefinedConflict::existing);
+		CHECK(conflicts[3].next == 3);
+		for (size_t i = 0; i < conflicts.size(); ++i)
+		{
+			if (i == 3)
+				continue;
+			CHECK(conflicts[i].name == "shared");
+			CHECK(conflicts[i].next == conflicts[i].previous + 1);
+		}
+
+		// Nothing is added if one fragment is invalid
+		fragments[10] = "{ \"variables\": ";
+		UserDefined invalid;
+		CHECK_THROWS_AS(invalid.addFromJsonFragments(fragments), nlohmann::json::parse_error);
+		CHECK(invalid.variables.empty());
+	}
 #endif
 
 } // namespace lac::an
@@ -2,11 +2,31 @@
 
 #include <lac/analysis/type_info.h>
 
+#include <iosfwd>
 #include <map>
 #include <string_view>
+#include <vector>
 
 namespace lac::an
 {
+	// Definition replaced when loading multiple json fragments
+	struct UserDefinedConflict
+	{
+		static constexpr size_t existing = static_cast<size_t>(-1); // Defined before the loading
+
+		enum class Category
+		{
+			type,
+			variable,
+			scriptInput
+		};
+
+		Category category;
+		std::string name;
+		size_t previous, next; // Indices of the fragments
+	};
+	using UserDefinedConflicts = std::vector<UserDefinedConflict>;
+
 	class CORE_API UserDefined
 	{
 	public:
@@ -22,7 +42,14 @@ namespace lac::an
 		const TypeInfo* getType(std::string_view name) const;
 
 #ifdef WITH_NLOHMANN_JSON
+		// The json is parsed as a stream, without creating the whole document in memory
 		void addFromJson(const std::string& json);
+		void addFromJson(std::istream& stream);
+		bool addFromJsonFile(const std::string& path); // Returns false if the file cannot be opened
+
+		// The fragments are loaded in parallel (0 thread means one per core), then merged in order as if addFromJson was called for each.
+		// If a fragment is invalid, nothing is added and the first error is thrown.
+		UserDefinedConflicts addFromJsonFragments(const std::vector<std::string>& fragments, size_t nbThreads = 0);
 		std::string toJson() const;
 #endif
 
@@ -0,0 +1,448 @@
+#include <lac/analysis/analyze_block.h>
+#include <lac/analysis/references.h>
+#include <lac/analysis/scope.h>
+#include <lac/analysis/workspace_index.h>
+#include <lac/helper/binary_stream.h>
+#include <lac/parser/parser.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+namespace
+{
+	using lac::an::WorkspaceSymbols;
+
+	constexpr std::string_view magic = "LACW";
+	constexpr uint64_t version = 1;
+	constexpr size_t maxMembersDepth = 8; // The members of the tables can be defined recursively
+
+	std::string toLower(std::string_view text)
+	{
+		std::string result{text};
+		for (auto& c : result)
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		return result;
+	}
+
+	// Sorted and unique
+	std::vector<uint32_t> getTrigrams(std::string_view key)
+	{
+		std::vector<uint32_t> trigrams;
+		for (size_t i = 0; i + 2 < key.size(); ++i)
+		{
+			trigrams.push_back(static_cast<uint32_t>(static_cast<unsigned char>(key[i])) << 16
+							   | static_cast<uint32_t>(static_cast<unsigned char>(key[i + 1])) << 8
+							   | static_cast<uint32_t>(static_cast<unsigned char>(key[i + 2])));
+		}
+
+		std::sort(trigrams.begin(), trigrams.end());
+		trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+		return trigrams;
+	}
+
+	// The whole name, then the last member, are better matches
+	double substringScore(std::string_view key, std::string_view query)
+	{
+		if (key == query)
+			return 4;
+
+		const auto separator = key.find_last_of(".:");
+		const auto member = separator == std::string_view::npos ? key : key.substr(separator + 1);
+		if (member == query)
+			return 3;
+		if (member.substr(0, query.size()) == query)
+			return 2.5;
+		return 2;
+	}
+
+	void addSymbols(WorkspaceSymbols& symbols, const std::string& name, const lac::an::TypeInfo& type, size_t position, size_t depth)
+	{
+		symbols.push_back({name, type.type, position});
+		if (type.type != lac::an::Type::table || depth >= maxMembersDepth)
+			return;
+
+		for (const auto& [memberName, member] : type.members)
+			addSymbols(symbols, name + (member.isMethod() ? ':' : '.') + memberName, member, position, depth + 1);
+	}
+} // namespace
+
+namespace lac::an
+{
+	WorkspaceSymbols getGlobalSymbols(const Scope& rootScope, const ReferenceIndex* references)
+	{
+		std::unordered_map<std::string, size_t> definitions;
+		std::unordered_set<std::string> globals;
+		if (references)
+		{
+			for (const auto& symbol : references->symbols())
+			{
+				if (symbol.scope != &rootScope)
+					continue;
+
+				if (symbol.local)
+					continue;
+
+				globals.insert(symbol.name);
+				if (symbol.definition)
+					definitions.emplace(symbol.name, symbol.definition->begin);
+			}
+		}
+
+		WorkspaceSymbols symbols;
+		for (const auto& [name, element] : rootScope.getElements())
+		{
+			if (!element.local) // Defined by the application
+				continue;
+			if (references && !globals.count(name)) // Only a local variable of the script, or of one of its blocks (like the loop variables)
+				continue;
+
+			const auto it = definitions.find(name);
+			addSymbols(symbols, name, element.typeInfo, it != definitions.end() ? it->second : std::string::npos, 0);
+		}
+
+		return symbols;
+	}
+
+	void WorkspaceIndex::updateFile(const std::string& file, WorkspaceSymbols symbols)
+	{
+		const auto [fileIt, inserted] = m_fileIds.emplace(file, static_cast<uint32_t>(m_files.size()));
+		if (inserted)
+		{
+			m_files.push_back(file);
+			m_fileEntries.emplace_back();
+		}
+
+		const auto fileId = fileIt->second;
+		removeFile(file);
+
+		auto& fileEntries = m_fileEntries[fileId];
+		for (auto& symbol : symbols)
+		{
+			uint32_t id = 0;
+			if (m_freeEntries.empty())
+			{
+				id = static_cast<uint32_t>(m_entries.size());
+				m_entries.emplace_back();
+			}
+			else
+			{
+				id = m_freeEntries.back();
+				m_freeEntries.pop_back();
+			}
+
+			auto& entry = m_entries[id];
+			entry.key = toLower(symbol.name);
+			entry.symbol = std::move(symbol);
+			entry.file = fileId;
+			entry.used = true;
+			addTrigrams(id);
+			fileEntries.push_back(id);
+		}
+
+		m_size += fileEntries.size();
+	}
+
+	void WorkspaceIndex::removeFile(const std::string& file)
+	{
+		const auto it = m_fileIds.find(file);
+		if (it == m_fileIds.end())
+			return;
+
+		auto& fileEntries = m_fileEntries[it->second];
+		for (const auto id : fileEntries)
+		{
+			removeTrigrams(id);
+			m_entries[id] = {};
+			m_freeEntries.push_back(id);
+		}
+
+		m_size -= fileEntries.size();
+		fileEntries.clear();
+	}
+
+	size_t WorkspaceIndex::size() const
+	{
+		return m_size;
+	}
+
+	WorkspaceMatches WorkspaceIndex::search(std::string_view query, size_t maxResults) const
+	{
+		const auto key = toLower(query);
+		if (key.empty() || !maxResults)
+			return {};
+
+		std::vector<std::pair<double, uint32_t>> found;
+		const auto queryTrigrams = getTrigrams(key);
+		if (queryTrigrams.empty())
+		{
+			// Too short to use the trigrams
+			for (uint32_t id = 0; id < m_entries.size(); ++id)
+			{
+				if (m_entries[id].used && m_entries[id].key.find(key) != std::string::npos)
+					found.emplace_back(substringScore(m_entries[id].key, key), id);
+			}
+		}
+		else
+		{
+			std::vector<const std::vector<uint32_t>*> lists;
+			for (const auto trigram : queryTrigrams)
+			{
+				const auto it = m_trigrams.find(trigram);
+				if (it != m_trigrams.end())
+					lists.push_back(&it->second);
+			}
+			std::sort(lists.begin(), lists.end(), [](const auto* lhs, const auto* rhs) {
+				return lhs->size() < rhs->size();
+			});
+
+			// The names containing the query have all its trigrams, start from the shortest list
+			if (!lists.empty() && lists.size() == queryTrigrams.size())
+			{
+				for (const auto id : *lists.front())
+				{
+					const auto inAll = std::all_of(lists.begin() + 1, lists.end(), [id](const auto* list) {
+						return std::binary_search(list->begin(), list->end(), id);
+					});
+					if (inAll && m_entries[id].key.find(key) != std::string::npos)
+						found.emplace_back(substringScore(m_entries[id].key, key), id);
+				}
+			}
+
+			// Similar names sharing at least half of the trigrams of the query
+			if (found.size() < maxResults)
+			{
+				std::unordered_map<uint32_t, size_t> shared;
+				for (const auto* list : lists)
+				{
+					for (const auto id : *list)
+						++shared[id];
+				}
+
+				const auto minShared = (queryTrigrams.size() + 1) / 2;
+				for (const auto& [id, count] : shared)
+				{
+					const auto& entryKey = m_entries[id].key;
+					if (count < minShared || entryKey.find(key) != std::string::npos)
+						continue;
+
+					const auto nbUnion = queryTrigrams.size() + entryKey.size() - 2 - count;
+					found.emplace_back(static_cast<double>(count) / nbUnion, id);
+				}
+			}
+		}
+
+		const auto nbResults = std::min(maxResults, found.size());
+		std::partial_sort(found.begin(), found.begin() + nbResults, found.end(), [this](const auto& lhs, const auto& rhs) {
+			if (lhs.first != rhs.first)
+				return lhs.first > rhs.first;
+			const auto& left = m_entries[lhs.second];
+			const auto& right = m_entries[rhs.second];
+			if (left.key.size() != right.key.size())
+				return left.key.size() < right.key.size();
+			if (left.symbol.name != right.symbol.name)
+				return left.symbol.name < right.symbol.name;
+			return m_files[left.file] < m_files[right.file];
+		});
+
+		WorkspaceMatches matches;
+		for (size_t i = 0; i < nbResults; ++i)
+		{
+			const auto& entry = m_entries[found[i].second];
+			matches.push_back({m_files[entry.file], entry.symbol, found[i].first});
+		}
+		return matches;
+	}
+
+	void WorkspaceIndex::write(std::string& buffer) const
+	{
+		// Only the symbols are written, the trigrams are computed again when reading
+		helper::BinaryWriter writer{buffer};
+		writer.writeRaw(magic);
+		writer.writeUnsigned(version);
+
+		const auto nbFiles = std::count_if(m_fileEntries.begin(), m_fileEntries.end(), [](const auto& entries) {
+			return !entries.empty();
+		});
+		writer.writeUnsigned(nbFiles);
+		for (size_t i = 0; i < m_files.size(); ++i)
+		{
+			const auto& fileEntries = m_fileEntries[i];
+			if (fileEntries.empty())
+				continue;
+
+			writer.writeString(m_files[i]);
+			writer.writeUnsigned(fileEntries.size());
+			for (const auto id : fileEntries)
+			{
+				const auto& symbol = m_entries[id].symbol;
+				writer.writeString(symbol.name);
+				writer.writeUnsigned(static_cast<uint64_t>(symbol.type));
+				writer.writeUnsigned(symbol.position == std::string::npos ? 0 : symbol.position + 1);
+			}
+		}
+	}
+
+	bool WorkspaceIndex::read(std::string_view data)
+	{
+		*this = {};
+		helper::BinaryReader reader{data};
+		if (reader.readRaw(magic.size()) != magic || reader.readUnsigned() != version)
+			return false;
+
+		// Each item takes at least one byte, this prevents allocating too much memory with invalid data
+		const auto nbFiles = reader.readUnsigned();
+		for (uint64_t i = 0; i < nbFiles && reader.ok(); ++i)
+		{
+			const std::string file{reader.readString()};
+			const auto nbSymbols = reader.readUnsigned();
+			if (nbSymbols > reader.remaining())
+				reader.fail();
+
+			WorkspaceSymbols symbols;
+			for (uint64_t j = 0; j < nbSymbols && reader.ok(); ++j)
+			{
+				WorkspaceSymbol symbol;
+				symbol.name = reader.readString();
+				const auto type = reader.readUnsigned();
+				if (type > static_cast<uint64_t>(Type::error))
+					reader.fail();
+				symbol.type = static_cast<Type>(type);
+				const auto position = reader.readUnsigned();
+				symbol.position = position ? static_cast<size_t>(position - 1) : std::string::npos;
+				symbols.push_back(std::move(symbol));
+			}
+
+			updateFile(file, std::move(symbols));
+		}
+
+		if (!reader.ok() || reader.remaining())
+		{
+			*this = {};
+			return false;
+		}
+		return true;
+	}
+
+	void WorkspaceIndex::addTrigrams(uint32_t id)
+	{
+		for (const auto trigram : getTrigrams(m_entries[id].key))
+		{
+			auto& list = m_trigrams[trigram];
+			list.insert(std::lower_bound(list.begin(), list.end(), id), id);
+		}
+	}
+
+	void WorkspaceIndex::removeTrigrams(uint32_t id)
+	{
+		for (const auto trigram : getTrigrams(m_entries[id].key))
+		{
+			const auto it = m_trigrams.find(trigram);
+			if (it == m_trigrams.end())
+				continue;
+
+			auto& list = it->second;
+			const auto pos = std::lower_bound(list.begin(), list.end(), id);
+			if (pos != list.end() && *pos == id)
+				list.erase(pos);
+			if (list.empty())
+				m_trigrams.erase(it);
+		}
+	}
+
+	TEST_CASE("Workspace index")
+	{
+		auto analyse = [](const std::string& program) {
+			const auto ret = parser::parseBlock(program);
+			REQUIRE(ret.parsed);
+			const auto scope = analyseBlock(ret.block);
+			const ReferenceIndex references{scope, program};
+			return getGlobalSymbols(scope, &references);
+		};
+
+		const std::string utils = R"~~(
+utils = {}
+function utils.clamp(v, min, max) return math.min(math.max(v, min), max) end
+function utils.lerp(a, b, t) return a + (b - a) * t end
+)~~";
+		const std::string node = R"~~(
+Node = { count = 0 }
+function Node:addChild(child) end
+function increment() Node.count = Node.count + 1 end
+local function privateThing() end
+local helper = 42
+for loopKey, loopValue in pairs(Node) do end
+)~~";
+
+		const auto utilsSymbols = analyse(utils);
+		REQUIRE(utilsSymbols.size() == 3);
+		CHECK(utilsSymbols[0].name == "utils");
+		CHECK(utilsSymbols[0].type == Type::table);
+		CHECK(utilsSymbols[0].position == utils.find("utils"));
+		CHECK(utilsSymbols[1].name == "utils.clamp");
+		CHECK(utilsSymbols[1].type == Type::function);
+
+		WorkspaceIndex index;
+		index.updateFile("utils.lua", utilsSymbols);
+		index.updateFile("node.lua", analyse(node));
+		CHECK(index.size() == 7);
+
+		// Substrings, ignoring the case
+		auto matches = index.search("CLAMP");
+		REQUIRE(matches.size() == 1);
+		CHECK(matches[0].file == "utils.lua");
+		CHECK(matches[0].symbol.name == "utils.clamp");
+
+		matches = index.search("node");
+		REQUIRE(matches.size() == 3);
+		CHECK(matches[0].symbol.name == "Node"); // Exact match first, then the shortest names
+		CHECK(matches[1].symbol.name == "Node.count");
+		CHECK(matches[2].symbol.name == "Node:addChild");
+
+		// Too short for the trigrams
+		matches = index.search("le");
+		REQUIRE(matches.size() == 1);
+		CHECK(matches[0].symbol.name == "utils.lerp");
+
+		// Similar names
+		matches = index.search("incremnt");
+		REQUIRE(matches.size() == 1);
+		CHECK(matches[0].symbol.name == "increment");
+		CHECK(matches[0].score < 1);
+		CHECK(index.search("addchilds").front().symbol.name == "Node:addChild");
+		CHECK(index.search("xyz").empty());
+
+		// Not the local variables of the scripts
+		CHECK(index.search("privateThing").empty());
+		CHECK(index.search("helper").empty());
+		CHECK(index.search("loopValue").empty());
+
+		// Update and removal of a file
+		index.updateFile("utils.lua", analyse("utils = { clamp = function() end }"));
+		CHECK(index.size() == 6);
+		CHECK(index.search("lerp").empty());
+		CHECK(index.search("clamp").size() == 1);
+		index.removeFile("node.lua");
+		CHECK(index.size() == 2);
+		CHECK(index.search("count").empty());
+
+		// Persistence
+		index.updateFile("node.lua", analyse(node));
+		std::string buffer;
+		index.write(buffer);
+
+		WorkspaceIndex restored;
+		REQUIRE(restored.read(buffer));
+		CHECK(restored.size() == index.size());
+		matches = restored.search("node");
+		REQUIRE(matches.size() == 3);
+		CHECK(matches[0].symbol.name == "Node");
+		CHECK(matches[0].symbol.position == node.find("Node"));
+
+		CHECK_FALSE(restored.read(buffer.substr(0, buffer.size() - 1)));
+		CHECK(restored.size() == 0);
+		CHECK_FALSE(restored.read("LACW"));
+	}
+} // namespace lac::an
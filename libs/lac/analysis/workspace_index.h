@@ -0,0 +1,73 @@
+#pragma once
+
+#include <lac/analysis/type_info.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lac::an
+{
+	class ReferenceIndex;
+
+	struct CORE_API WorkspaceSymbol
+	{
+		std::string name;                    // With the tables containing it, like "utils.clamp" or "Node:child"
+		Type type = Type::unknown;
+		size_t position = std::string::npos; // Offset of the definition in the file, if known
+	};
+	using WorkspaceSymbols = std::vector<WorkspaceSymbol>;
+
+	struct CORE_API WorkspaceMatch
+	{
+		std::string file;
+		WorkspaceSymbol symbol;
+		double score = 0; // Above 1 if the name contains the query, else the similarity of their trigrams
+	};
+	using WorkspaceMatches = std::vector<WorkspaceMatch>;
+
+	// Global variables of an analysed root scope and the members of the global tables.
+	// The references give the position of the definitions of the globals (the members use the one of their table).
+	// They also tell which variables are only local to the script, without them these are returned as well.
+	CORE_API WorkspaceSymbols getGlobalSymbols(const Scope& rootScope, const ReferenceIndex* references = nullptr);
+
+	// Symbols of all the files of a workspace, searched by partial names using their trigrams
+	class CORE_API WorkspaceIndex
+	{
+	public:
+		void updateFile(const std::string& file, WorkspaceSymbols symbols); // Replace the previous symbols of the file
+		void removeFile(const std::string& file);
+
+		size_t size() const;
+
+		// The symbols containing the query (ignoring the case) first, then the ones sharing most of its trigrams
+		WorkspaceMatches search(std::string_view query, size_t maxResults = 50) const;
+
+		void write(std::string& buffer) const;
+		bool read(std::string_view data); // The index is empty if the data is not valid
+
+	private:
+		struct Entry
+		{
+			WorkspaceSymbol symbol;
+			std::string key; // Lower case name
+			uint32_t file = 0;
+			bool used = false;
+		};
+
+		void addTrigrams(uint32_t id);
+		void removeTrigrams(uint32_t id);
+
+		std::vector<Entry> m_entries;
+		std::vector<uint32_t> m_freeEntries;
+
+		std::vector<std::string> m_files;
+		std::unordered_map<std::string, uint32_t> m_fileIds;
+		std::vector<std::vector<uint32_t>> m_fileEntries;
+
+		std::unordered_map<uint32_t, std::vector<uint32_t>> m_trigrams; // Sorted entries containing each trigram
+		size_t m_size = 0;
+	};
+} // namespace lac::an
@@ -45,6 +45,46 @@ namespace
 		}
 		return out;
 	}
+
+	// Filter only the keyword in the list of elements
+	lac::pos::Elements filterKeywords(const lac::pos::Elements& elements)
+	{
+		lac::pos::Elements keywords;
+		std::copy_if(elements.begin(), elements.end(), std::back_inserter(keywords), [](const lac::pos::Element& elt) {
+			return elt.type == lac::ast::ElementType::keyword;
+		});
+		return keywords;
+	}
+
+	// Get the result from the cache, or compute it for the variable under the cursor and store it
+	template <class T, class Cache, class Func>
+	T getCachedResult(Cache& cache, const lac::an::Scope& rootScope, std::string_view str, size_t pos, Func func)
+	{
+		if (pos == std::string_view::npos)
+			pos = str.size() - 1;
+
+		const auto extracted = lac::comp::extractVariableAtPos(str, pos);
+		if (extracted.empty())
+			return {};
+
+		const auto scope = lac::pos::getScopeAtPos(rootScope, pos);
+		if (!scope)
+			return {};
+
+		auto& scopeCache = cache[scope];
+		auto key = lac::comp::normalizeVariable(extracted);
+		const auto it = scopeCache.find(key);
+		if (it != scopeCache.end())
+			return it->second;
+
+		T result{};
+		const auto ret = lac::parser::parseVariable(extracted);
+		if (ret.parsed)
+			result = func(*scope, ret.variable);
+
+		scopeCache.emplace(std::move(key), result);
+		return result;
+	}
 } // namespace
 
 namespace lac::comp
@@ -52,6 +92,8 @@ namespace lac::comp
 	void Completion::setUserDefined(lac::an::UserDefined userDefined)
 	{
 		m_userDefined = std::move(userDefined);
+		m_diagnostics.clear(); // The types of the previous results may have changed
+		clearCache();
 	}
 
 	lac::an::UserDefined Completion::userDefined() const
@@ -61,6 +103,16 @@ namespace lac::comp
 				   : lac::an::UserDefined{};
 	}
 
+	void Completion::setLazyAnalysis(bool lazy)
+	{
+		m_lazyAnalysis = lazy;
+	}
+
+	void Completion::setReferenceIndex(bool enabled)
+	{
+		m_referenceIndex = enabled;
+	}
+
 	bool Completion::updateProgram(std::string_view view, size_t currentPosition)
 	{
 		if (view.empty())
@@ -99,10 +151,35 @@ namespace lac::comp
 			m_rootScope = an::Scope{m_rootBlock};
 			if (m_userDefined)
 				m_rootScope.setUserDefined(&m_userDefined.get());
-			an::analyseBlock(m_rootScope, m_rootBlock);
+
+			// The types of the expressions are shared by the analysis and the diagnostics
+			m_expressionTypes.clear();
+			m_rootScope.setTypeCache(&m_expressionTypes);
+			if (m_lazyAnalysis)
+			{
+				an::analyseBlockLazy(m_rootScope, m_rootBlock);
+				m_references = {};
+				m_diagnostics.clear();
+			}
+			else
+			{
+				an::analyseBlock(m_rootScope, m_rootBlock);
+
+				// Before extending the blocks, so that the scopes of the functions begin after their parameters
+				m_references = m_referenceIndex
+								   ? an::ReferenceIndex{m_rootScope, view}
+								   : an::ReferenceIndex{};
+				m_diagnostics.update(m_rootScope, view, m_references);
+			}
+
+			// Not for the queries, their expressions are parsed in temporary nodes whose addresses are reused
+			m_rootScope.setTypeCache(nullptr);
 
 			// Extend each block until the following keyword
 			extendBlock(m_rootScope, m_positions.elements());
+
+			m_sortedElements = pos::SortedElements{m_positions.elements()};
+			clearCache();
 		}
 
 		// Always update the boundary of the root block
@@ -113,11 +190,13 @@ namespace lac::comp
 
 	an::ElementsMap Completion::getVariableCompletionList(std::string_view str, size_t pos)
 	{
+		analyseFunctionsAtPos(str, pos);
 		return comp::getAutoCompletionList(m_rootScope, str, pos);
 	}
 
 	an::ElementsMap Completion::getArgumentCompletionList(std::string_view str, size_t pos)
 	{
+		analyseFunctionsAtPos(str, pos);
 		const auto argData = getArgumentAtPos(m_rootScope, str, pos);
 		if (argData && argData->function.function.getCompletionFunc)
 		{
@@ -133,7 +212,8 @@ namespace lac::comp
 
 	an::TypeInfo Completion::getTypeAtPos(std::string_view str, size_t pos)
 	{
-		return comp::getTypeAtPos(m_rootScope, str, pos);
+		analyseFunctionsAtPos(str, pos);
+		return getCachedResult<an::TypeInfo>(m_typeCache, m_rootScope, str, pos, comp::getVariableType);
 	}
 
 	std::string Completion::getVariableNameAtPos(std::string_view str, size_t pos)
@@ -172,7 +252,70 @@ namespace lac::comp
 
 	std::vector<std::string> Completion::getTypeHierarchyAtPos(std::string_view str, size_t pos)
 	{
-		return comp::getTypeHierarchyAtPos(m_rootScope, str, pos);
+		analyseFunctionsAtPos(str, pos);
+		return getCachedResult<std::vector<std::string>>(m_typeHierarchyCache, m_rootScope, str, pos, comp::getTypeHierarchy);
+	}
+
+	boost::optional<pos::Element> Completion::getDefinitionAtPos(size_t pos) const
+	{
+		return m_references.getDefinitionAtPos(pos);
+	}
+
+	pos::Elements Completion::getReferencesAtPos(size_t pos) const
+	{
+		return m_references.getReferencesAtPos(pos);
+	}
+
+	const an::Diagnostics& Completion::getDiagnostics() const
+	{
+		return m_diagnostics.diagnostics();
+	}
+
+	const an::ExpressionTypeCache& Completion::expressionTypes() const
+	{
+		return m_expressionTypes;
+	}
+
+	void Completion::analyseFunctionsAtPos(std::string_view str, size_t pos)
+	{
+		if (!m_lazyAnalysis)
+			return;
+		if (pos == std::string_view::npos)
+			pos = str.size() - 1;
+
+		// Same as getScopeAtPos, analysing the functions skipped on the way, whose new children must have their blocks extended
+		const auto& elements = m_positions.elements();
+		pos::Elements keywords;
+		an::Scope* scope = &m_rootScope;
+		while (scope)
+		{
+			if (an::analysePendingScope(*scope))
+			{
+				if (keywords.empty())
+					keywords = filterKeywords(elements);
+				for (const auto& child : scope->children())
+					extendBlock(child, elements, keywords);
+			}
+
+			auto& children = scope->modifyChildren();
+			const auto it = std::find_if(children.begin(), children.end(), [pos](const an::Scope& child) {
+				const auto block = child.block();
+				return block && block->begin <= pos && block->end >= pos;
+			});
+			scope = it != children.end() ? &*it : nullptr;
+		}
+	}
+
+	void Completion::clearCache()
+	{
+		// The scopes are recreated by the analysis, and the types can change
+		m_typeCache.clear();
+		m_typeHierarchyCache.clear();
+	}
+
+	pos::Elements Completion::getElementsInRange(size_t begin, size_t end) const
+	{
+		return m_sortedElements.inRange(begin, end);
 	}
 
 	boost::optional<ast::VariableOrFunction> removeLastPart(ast::VariableOrFunction var)
@@ -231,7 +374,7 @@ namespace lac::comp
 
 			--pos;
 			// Ignore the whitespace
-			while (pos != 0 && std::isspace(str[pos]))
+			while (pos != 0 && std::isspace(static_cast<unsigned char>(str[pos])))
 				--pos;
 
 			auto var = parseVariableAtPos(str, pos); // Do not remove the last part, as it does not exist
@@ -307,17 +450,16 @@ namespace lac::comp
 	}
 
 	void extendBlock(const an::Scope& scope, const pos::Elements& elements)
+	{
+		extendBlock(scope, elements, filterKeywords(elements));
+	}
+
+	void extendBlock(const an::Scope& scope, const pos::Elements& elements, const pos::Elements& keywords)
 	{
 		auto block = scope.block();
 		if (!block)
 			return;
 
-		// Filter only the keyword in the list of elements
-		pos::Elements keywords;
-		std::copy_if(elements.begin(), elements.end(), std::back_inserter(keywords), [](const pos::Element& elt) {
-			return elt.type == ast::ElementType::keyword;
-		});
-
 		// Find the keyword just before the start of the block
 		auto reversed = helper::reverse{elements};
 		auto itStart = helper::upper_bound(reversed, block->begin, [](size_t pos, const pos::Element& elt) {
@@ -335,6 +477,6 @@ namespace lac::comp
 
 		// Process the children blocks
 		for (const auto& child : scope.children())
-			extendBlock(child, elements);
+			extendBlock(child, elements, keywords);
 	}
 } // namespace lac::comp
@@ -2,11 +2,16 @@
 
 #include <lac/parser/ast.h>
 #include <lac/parser/positions.h>
+#include <lac/analysis/diagnostics.h>
+#include <lac/analysis/get_type.h>
+#include <lac/analysis/references.h>
 #include <lac/analysis/scope.h>
 #include <lac/analysis/user_defined.h>
 
 #include <boost/optional.hpp>
 
+#include <unordered_map>
+
 namespace lac
 {
 	namespace comp
@@ -24,6 +29,15 @@ namespace lac
 			void setUserDefined(lac::an::UserDefined userDefined);
 			lac::an::UserDefined userDefined() const;
 
+			// Only analyse the statements outside of the functions in updateProgram, for the large files.
+			// The function under the cursor is analysed by the first query inside it. The references and the
+			// diagnostics need all the functions, they are not computed in this mode.
+			void setLazyAnalysis(bool lazy);
+
+			// Build the reference index in updateProgram, for getDefinitionAtPos and getReferencesAtPos. Disabled by default.
+			// The diagnostics only report the undefined variables when it is enabled.
+			void setReferenceIndex(bool enabled);
+
 			bool updateProgram(std::string_view str, size_t currentPosition = std::string_view::npos);
 			an::ElementsMap getVariableCompletionList(std::string_view str, size_t pos = std::string_view::npos);
 			an::ElementsMap getArgumentCompletionList(std::string_view str, size_t pos = std::string_view::npos);
@@ -31,11 +45,40 @@ namespace lac
 			std::string getVariableNameAtPos(std::string_view str, size_t pos); // Returns empty string if it is not a name at this position
 			std::vector<std::string> getTypeHierarchyAtPos(std::string_view str, size_t pos);
 
+			// Elements of the last successful parse overlapping [begin, end), used for highlighting only the visible part of the text
+			pos::Elements getElementsInRange(size_t begin, size_t end) const;
+
+			// Declaration and uses of the variable at this position, from the last successful analysis (see setReferenceIndex)
+			boost::optional<pos::Element> getDefinitionAtPos(size_t pos) const;
+			pos::Elements getReferencesAtPos(size_t pos) const;
+
+			// Semantic errors of the last successful analysis, only the modified functions are checked again.
+			// The undefined variables are only reported if the reference index is enabled (see setReferenceIndex).
+			const an::Diagnostics& getDiagnostics() const;
+
+			// Types computed during the last update, with the number of times they were reused
+			const an::ExpressionTypeCache& expressionTypes() const;
+
 		private:
+			void clearCache();
+			void analyseFunctionsAtPos(std::string_view str, size_t pos); // In the lazy mode, before a query
+
+			bool m_lazyAnalysis = false;
+			bool m_referenceIndex = false;
 			boost::optional<lac::an::UserDefined> m_userDefined;
 			ast::Block m_rootBlock;
 			an::Scope m_rootScope;
 			pos::Positions<std::string_view::const_iterator> m_positions;
+			pos::SortedElements m_sortedElements;
+			an::ReferenceIndex m_references;
+			an::DiagnosticsEngine m_diagnostics;
+			an::ExpressionTypeCache m_expressionTypes;
+
+			// Results of the hover queries for the current analysis, by scope then by normalized variable
+			template <class T>
+			using QueryCache = std::unordered_map<const an::Scope*, std::unordered_map<std::string, T>>;
+			QueryCache<an::TypeInfo> m_typeCache;
+			QueryCache<std::vector<std::string>> m_typeHierarchyCache;
 		};
 
 		// Remove the last member of the variable. If not possible, return empty.
@@ -50,5 +93,6 @@ namespace lac
 
 		// Extend the block in the scope until the following keyword (and recurse over children)
 		void extendBlock(const an::Scope& scope, const pos::Elements& elements);
+		void extendBlock(const an::Scope& scope, const pos::Elements& elements, const pos::Elements& keywords); // Keywords filtered from the elements
 	} // namespace comp
 } // namespace lac
@@ -346,6 +346,33 @@ myTable.m_meth2 = function(self, a) return a * 2 end
 			CHECK(completion.getVariableCompletionList("myTable:").size() == 2);
 			CHECK(completion.getVariableCompletionList("myTable:method1").size() == 2);
 			CHECK(completion.getVariableCompletionList("myTable:dummy").size() == 2);
+
+			// References, only when enabled
+			CHECK(completion.getReferencesAtPos(program.find("myTable")).empty());
+			completion.setReferenceIndex(true);
+			REQUIRE(completion.updateProgram(program));
+			CHECK(completion.getReferencesAtPos(program.find("myTable")).size() == 8);
+			const auto definition = completion.getDefinitionAtPos(program.rfind("myTable"));
+			REQUIRE(definition.has_value());
+			CHECK(definition->begin == program.find("myTable"));
+		}
+
+		TEST_CASE("Completion diagnostics")
+		{
+			const std::string program = "local n = #1\nprint(unknown)";
+
+			// The undefined variables need the reference index
+			Completion completion;
+			REQUIRE(completion.updateProgram(program));
+			REQUIRE(completion.getDiagnostics().size() == 1);
+			CHECK(completion.getDiagnostics()[0].type == an::DiagnosticType::invalidOperation);
+
+			completion.setReferenceIndex(true);
+			REQUIRE(completion.updateProgram(program));
+			REQUIRE(completion.getDiagnostics().size() == 2);
+			CHECK(completion.getDiagnostics()[0].type == an::DiagnosticType::invalidOperation);
+			CHECK(completion.getDiagnostics()[1].type == an::DiagnosticType::undefinedVariable);
+			CHECK(completion.getDiagnostics()[1].begin == program.find("unknown"));
 		}
 
 		TEST_CASE("Completion with errors")
@@ -556,6 +583,156 @@ len = vec:length()
 			CHECK(getTypeHierarchyAtPos(scope, "getPos()[1]:length") == StrVec{ "Vector3", "length" });
 		}
 
+		TEST_CASE("Completion of returned tables")
+		{
+			std::string program = R"~~(
+function newPlayer()
+	local player = { name = "bob", level = 1 }
+	function player.greet() end
+	return player
+end
+local p = newPlayer()
+)~~";
+			Completion completion;
+			REQUIRE(completion.updateProgram(program));
+
+			auto list = completion.getVariableCompletionList("newPlayer().");
+			CHECK(list.size() == 3);
+			CHECK(list.count("greet"));
+
+			list = completion.getVariableCompletionList("p.");
+			CHECK(list.size() == 3);
+			CHECK(list.count("level"));
+
+			CHECK(completion.getTypeAtPos(program, program.find("newPlayer()")).functionDefinition() == "table function()");
+		}
+
+		TEST_CASE("Completion of class instances")
+		{
+			std::string program = R"~~(
+local Account = {}
+Account.__index = Account
+function Account.new(balance)
+	return setmetatable({balance = balance}, Account)
+end
+function Account:deposit(v) end
+function Account:withdraw(v) end
+
+local Savings = setmetatable({}, {__index = Account})
+Savings.__index = Savings
+function Savings:addInterest() end
+
+local a = Account.new(10)
+local s = setmetatable({}, Savings)
+)~~";
+			Completion completion;
+			REQUIRE(completion.updateProgram(program));
+
+			auto list = completion.getVariableCompletionList("a:");
+			CHECK(list.size() == 2);
+			CHECK(list.count("deposit"));
+			CHECK(list.count("withdraw"));
+
+			list = completion.getVariableCompletionList("s:");
+			CHECK(list.size() == 3);
+			CHECK(list.count("addInterest"));
+			CHECK(list.count("deposit"));
+
+			list = completion.getVariableCompletionList("a.");
+			CHECK(list.count("balance"));
+		}
+
+		TEST_CASE("Lazy completion")
+		{
+			std::string program = R"~~(
+local config = { debug = true }
+function first(a)
+	local point = { x = a, y = 2 }
+	local function nested()
+		local inner = { z = 3 }
+		print(inner.z)
+	end
+	print(point.x)
+end
+function second()
+	local other = 1
+end
+)~~";
+			Completion completion;
+			completion.setLazyAnalysis(true);
+			REQUIRE(completion.updateProgram(program));
+
+			auto list = completion.getVariableCompletionList("config.");
+			CHECK(list.size() == 1);
+
+			// The function under the cursor is analysed by the query
+			const auto pointPos = program.find("point.x") + 5;
+			list = completion.getVariableCompletionList(program, pointPos);
+			CHECK(list.size() == 2);
+			CHECK(list.count("x"));
+
+			const auto innerPos = program.find("inner.z") + 5;
+			list = completion.getVariableCompletionList(program, innerPos);
+			CHECK(list.size() == 1);
+			CHECK(list.count("z"));
+			CHECK(completion.getTypeAtPos(program, program.find("inner.z") + 2).type == an::Type::table);
+
+			// Same results without the lazy mode
+			completion.setLazyAnalysis(false);
+			REQUIRE(completion.updateProgram(program));
+			list = completion.getVariableCompletionList(program, innerPos);
+			CHECK(list.size() == 1);
+			CHECK(list.count("z"));
+		}
+
+		TEST_CASE("Cached type at position")
+		{
+			using namespace lac::an;
+			UserDefined userDefined;
+			TypeInfo nodeType = Type::table;
+			nodeType.name = "Node";
+			nodeType.members["x"] = Type::number;
+			userDefined.addType(std::move(nodeType));
+
+			int nbCalls = 0;
+			auto getNode = [&nbCalls](const Scope&, const ast::Arguments&, const TypeInfo&) {
+				++nbCalls;
+				return TypeInfo::fromTypeName("Node");
+			};
+			userDefined.addVariable("getNode", TypeInfo::createFunction({}, {}, getNode));
+
+			const std::string program = "print(getNode().x)\nprint(getNode ( ) . x)\n";
+			const auto first = program.find("()") + 1;
+			const auto second = program.find(" )") + 1;
+
+			Completion completion;
+			completion.setUserDefined(userDefined);
+			REQUIRE(completion.updateProgram(program));
+
+			// The same variable is only resolved once, even when written differently
+			nbCalls = 0;
+			CHECK(completion.getTypeAtPos(program, first).name == "Node");
+			CHECK(nbCalls == 1);
+			CHECK(completion.getTypeAtPos(program, first).name == "Node");
+			CHECK(completion.getTypeAtPos(program, second).name == "Node");
+			CHECK(nbCalls == 1);
+
+			using StrVec = std::vector<std::string>;
+			const auto member = program.find(". x") + 2;
+			CHECK(completion.getTypeHierarchyAtPos(program, member) == StrVec{"Node", "x"});
+			CHECK(completion.getTypeHierarchyAtPos(program, member) == StrVec{"Node", "x"});
+
+			// Nothing under the cursor
+			CHECK(completion.getTypeAtPos(program, 5).type == Type::nil);
+			CHECK(completion.getTypeAtPos(program, program.size() - 1).type == Type::nil);
+
+			// The cache is cleared by a new analysis
+			const std::string modified = "local getNode = 42\n" + program;
+			REQUIRE(completion.updateProgram(modified));
+			CHECK(completion.getTypeAtPos(modified, modified.find("getNode()")).type == Type::number);
+			CHECK(completion.getTypeAtPos(modified, modified.find("()") + 1).name.empty());
+		}
+
 		TEST_SUITE_END();
 	} // namespace comp
 } // namespace lac
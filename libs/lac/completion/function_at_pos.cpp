@@ -24,7 +24,7 @@ namespace lac::comp
 
 		// Go left while the character is a whitespace
 		auto ignoreWhiteSpace = [&ps, &view] {
-			while (ps != 0 && std::isspace(view[ps - 1]))
+			while (ps != 0 && std::isspace(static_cast<unsigned char>(view[ps - 1])))
 				--ps;
 		};
 
@@ -323,14 +323,19 @@ namespace lac::comp
 		if (!scope)
 			return {};
 
+		return getTypeHierarchy(*scope, *var);
+	}
+
+	std::vector<std::string> getTypeHierarchy(const an::Scope& localScope, const ast::VariableOrFunction& var)
+	{
 		std::vector<std::string> hierarchy;
-		if (var->start.get().type() == typeid(ast::Variable))
-			hierarchy = getTypeHierarchy(*scope, boost::get<ast::Variable>(var->start));
+		if (var.start.get().type() == typeid(ast::Variable))
+			hierarchy = ::getTypeHierarchy(localScope, boost::get<ast::Variable>(var.start));
 		else
-			hierarchy = getTypeHierarchy(*scope, boost::get<ast::FunctionCall>(var->start));
+			hierarchy = ::getTypeHierarchy(localScope, boost::get<ast::FunctionCall>(var.start));
 
-		if (var->member)
-			hierarchy.push_back(var->member->name);
+		if (var.member)
+			hierarchy.push_back(var.member->name);
 		return hierarchy;
 	}
 
@@ -23,4 +23,7 @@ namespace lac::comp
 
 	// Return the name of the type and the chain of members of the variable under the cursor
 	CORE_API std::vector<std::string> getTypeHierarchyAtPos(const an::Scope& rootScope, std::string_view view, size_t pos = std::string_view::npos);
+
+	// Return the name of the type and the chain of members of the given variable
+	CORE_API std::vector<std::string> getTypeHierarchy(const an::Scope& localScope, const ast::VariableOrFunction& var);
 } // namespace lac::comp
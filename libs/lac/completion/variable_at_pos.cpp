@@ -6,9 +6,9 @@
 
 namespace
 {
-	bool isName(int ch)
+	bool isName(char ch)
 	{
-		return std::isalnum(ch) || ch == '_';
+		return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
 	}
 } // namespace
 
@@ -39,7 +39,7 @@ namespace lac::comp
 
 		// Go left while the character is a whitespace
 		auto ignoreWhiteSpace = [&ps, &view] {
-			while (ps != 0 && std::isspace(view[ps - 1]))
+			while (ps != 0 && std::isspace(static_cast<unsigned char>(view[ps - 1])))
 				--ps;
 		};
 
@@ -175,6 +175,45 @@ namespace lac::comp
 		return {};
 	}
 
+	std::string normalizeVariable(std::string_view view)
+	{
+		// Whitespace in long literal strings is significant, keep these variables as they are
+		if (view.find("[[") != std::string_view::npos || view.find("[=") != std::string_view::npos)
+			return std::string{view};
+
+		std::string result;
+		result.reserve(view.size());
+		char quote = 0;
+		bool space = false;
+		for (size_t i = 0; i < view.size(); ++i)
+		{
+			const auto c = view[i];
+			if (quote) // Copy the short literal strings
+			{
+				result += c;
+				if (c == '\\' && i + 1 < view.size())
+					result += view[++i];
+				else if (c == quote)
+					quote = 0;
+			}
+			else if (std::isspace(static_cast<unsigned char>(c)))
+				space = true;
+			else
+			{
+				// Only keep a space between two names
+				if (space && !result.empty() && isName(result.back()) && isName(c))
+					result += ' ';
+				space = false;
+
+				if (c == '\'' || c == '"')
+					quote = c;
+				result += c;
+			}
+		}
+
+		return result;
+	}
+
 	TEST_SUITE_BEGIN("Parse current line");
 
 	TEST_CASE("Name only")
@@ -310,5 +349,16 @@ namespace lac::comp
 		CHECK(extractVariableAtPos("test foo(a).m[x]", 15) == "foo(a).m[x]");
 	}
 
+	TEST_CASE("Normalize variable")
+	{
+		CHECK(normalizeVariable("foo") == "foo");
+		CHECK(normalizeVariable("foo [ x ] . bar") == "foo[x].bar");
+		CHECK(normalizeVariable("foo ( a,\tb ) : bar") == "foo(a,b):bar");
+		CHECK(normalizeVariable("foo(x and y)") == "foo(x and y)");
+		CHECK(normalizeVariable("foo[ 'a  b' ].bar") == "foo['a  b'].bar");
+		CHECK(normalizeVariable("foo[ \"a \\\" b\" ]") == "foo[\"a \\\" b\"]");
+		CHECK(normalizeVariable("foo[ [[a  b]] ]") == "foo[ [[a  b]] ]");
+	}
+
 	TEST_SUITE_END();
 } // namespace lac::comp
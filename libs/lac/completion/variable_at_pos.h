@@ -9,4 +9,7 @@ namespace lac::comp
 
 	// Extract and parse the variable under the cursor
 	boost::optional<ast::VariableOrFunction> parseVariableAtPos(std::string_view view, size_t pos = std::string_view::npos);
+
+	// Remove the whitespace that does not change the meaning of an extracted variable, so that it can be used as a key
+	std::string normalizeVariable(std::string_view view);
 } // namespace lac::comp
@@ -0,0 +1,188 @@
+#include <lac/helper/binary_stream.h>
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+#include <limits>
+
+namespace lac::helper
+{
+	BinaryWriter::BinaryWriter(std::string& buffer)
+		: m_buffer(buffer)
+	{
+	}
+
+	void BinaryWriter::writeByte(uint8_t value)
+	{
+		m_buffer += static_cast<char>(value);
+	}
+
+	void BinaryWriter::writeUnsigned(uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			m_buffer += static_cast<char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		m_buffer += static_cast<char>(value);
+	}
+
+	void BinaryWriter::writeSigned(int64_t value)
+	{
+		writeUnsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+	}
+
+	void BinaryWriter::writeDouble(double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		for (int i = 0; i < 8; ++i)
+			m_buffer += static_cast<char>((bits >> (i * 8)) & 0xFF); // Little endian, whatever the platform
+	}
+
+	void BinaryWriter::writeString(std::string_view value)
+	{
+		writeUnsigned(value.size());
+		m_buffer += value;
+	}
+
+	void BinaryWriter::writeRaw(std::string_view data)
+	{
+		m_buffer += data;
+	}
+
+	/****************************************************************************/
+
+	BinaryReader::BinaryReader(std::string_view data)
+		: m_data(data)
+	{
+	}
+
+	uint8_t BinaryReader::readByte()
+	{
+		if (!m_ok || m_pos >= m_data.size())
+		{
+			fail();
+			return 0;
+		}
+		return static_cast<uint8_t>(m_data[m_pos++]);
+	}
+
+	uint64_t BinaryReader::readUnsigned()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			const auto byte = readByte();
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return value;
+		}
+
+		fail(); // Too many bytes
+		return 0;
+	}
+
+	int64_t BinaryReader::readSigned()
+	{
+		const auto value = readUnsigned();
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	double BinaryReader::readDouble()
+	{
+		const auto data = readRaw(8);
+		if (data.size() != 8)
+			return 0;
+
+		uint64_t bits = 0;
+		for (int i = 0; i < 8; ++i)
+			bits |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (i * 8);
+
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	std::string_view BinaryReader::readString()
+	{
+		const auto size = readUnsigned();
+		if (size > remaining())
+		{
+			fail();
+			return {};
+		}
+		return readRaw(static_cast<size_t>(size));
+	}
+
+	std::string_view BinaryReader::readRaw(size_t size)
+	{
+		if (!m_ok || size > remaining())
+		{
+			fail();
+			return {};
+		}
+
+		const auto data = m_data.substr(m_pos, size);
+		m_pos += size;
+		return data;
+	}
+
+	bool BinaryReader::ok() const
+	{
+		return m_ok;
+	}
+
+	void BinaryReader::fail()
+	{
+		m_ok = false;
+	}
+
+	size_t BinaryReader::remaining() const
+	{
+		return m_ok ? m_data.size() - m_pos : 0;
+	}
+
+	TEST_CASE("Binary stream")
+	{
+		std::string buffer;
+		BinaryWriter writer{buffer};
+		writer.writeUnsigned(0);
+		writer.writeUnsigned(127);
+		writer.writeUnsigned(128);
+		writer.writeUnsigned(std::numeric_limits<uint64_t>::max());
+		writer.writeSigned(-1);
+		writer.writeSigned(std::numeric_limits<int64_t>::min());
+		writer.writeDouble(3.25);
+		writer.writeString("text");
+		writer.writeByte(42);
+		CHECK(buffer.size() == 1 + 1 + 2 + 10 + 1 + 10 + 8 + 5 + 1);
+
+		BinaryReader reader{buffer};
+		CHECK(reader.readUnsigned() == 0);
+		CHECK(reader.readUnsigned() == 127);
+		CHECK(reader.readUnsigned() == 128);
+		CHECK(reader.readUnsigned() == std::numeric_limits<uint64_t>::max());
+		CHECK(reader.readSigned() == -1);
+		CHECK(reader.readSigned() == std::numeric_limits<int64_t>::min());
+		CHECK(reader.readDouble() == 3.25);
+		const auto text = reader.readString();
+		CHECK(text == "text");
+		CHECK(text.data() == buffer.data() + buffer.size() - 5); // Not copied
+		CHECK(reader.readByte() == 42);
+		CHECK(reader.ok());
+		CHECK(reader.remaining() == 0);
+
+		// Reading past the end
+		CHECK(reader.readByte() == 0);
+		CHECK_FALSE(reader.ok());
+
+		// Truncated string
+		BinaryReader truncated{std::string_view{buffer}.substr(0, buffer.size() - 3)};
+		for (int i = 0; i < 6; ++i)
+			truncated.readUnsigned();
+		CHECK(truncated.readDouble() == 3.25);
+		CHECK(truncated.readString().empty());
+		CHECK_FALSE(truncated.ok());
+	}
+} // namespace lac::helper
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <lac/core_api.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lac::helper
+{
+	// Appends values to a buffer in a compact form: integers are written as varints, strings are prefixed by their size.
+	class CORE_API BinaryWriter
+	{
+	public:
+		BinaryWriter(std::string& buffer);
+
+		void writeByte(uint8_t value);
+		void writeUnsigned(uint64_t value);
+		void writeSigned(int64_t value); // Zigzag encoding, so that small negative values are small too
+		void writeDouble(double value);
+		void writeString(std::string_view value);
+		void writeRaw(std::string_view data);
+
+	private:
+		std::string& m_buffer;
+	};
+
+	// Reads the values written by BinaryWriter, without copying the data.
+	// Reading past the end or invalid values put the reader in a failed state, after which only default values are returned.
+	class CORE_API BinaryReader
+	{
+	public:
+		BinaryReader(std::string_view data);
+
+		uint8_t readByte();
+		uint64_t readUnsigned();
+		int64_t readSigned();
+		double readDouble();
+		std::string_view readString(); // Points into the data
+		std::string_view readRaw(size_t size);
+
+		bool ok() const;
+		void fail();
+		size_t remaining() const;
+
+	private:
+		std::string_view m_data;
+		size_t m_pos = 0;
+		bool m_ok = true;
+	};
+} // namespace lac::helper
@@ -10,6 +10,20 @@
 
 namespace lac::helper
 {
+	// A failed expectation is reported as a failed parse
+	template <class Func>
+	bool parse_or_fail(Func func)
+	{
+		try
+		{
+			return func();
+		}
+		catch (const boost::spirit::x3::expectation_failure<std::string_view::const_iterator>&)
+		{
+			return false;
+		}
+	}
+
 	// Attributes are given by the caller
 	template <class P, class... Args>
 	bool test_parser(std::string_view input, const P& p, Args&... args)
@@ -18,7 +32,7 @@ namespace lac::helper
 		const auto l = input.end();
 		pos::Positions positions{f, l};
 		const auto parser = boost::spirit::x3::with<pos::position_tag>(std::ref(positions))[p];
-		return boost::spirit::x3::parse(f, l, parser, args...) && f == l;
+		return parse_or_fail([&] { return boost::spirit::x3::parse(f, l, parser, args...); }) && f == l;
 	}
 
 	// A dummy attribute is added
@@ -31,7 +45,7 @@ namespace lac::helper
 		const auto parser = boost::spirit::x3::with<pos::position_tag>(std::ref(positions))[p];
 
 		typename P::attribute_type val;
-		return boost::spirit::x3::parse(f, l, parser, val) && f == l;
+		return parse_or_fail([&] { return boost::spirit::x3::parse(f, l, parser, val); }) && f == l;
 	}
 
 	// The rule does not have an attribute
@@ -42,7 +56,7 @@ namespace lac::helper
 		const auto l = input.end();
 		pos::Positions positions{f, l};
 		const auto parser = boost::spirit::x3::with<pos::position_tag>(std::ref(positions))[p];
-		return boost::spirit::x3::parse(f, l, parser) && f == l;
+		return parse_or_fail([&] { return boost::spirit::x3::parse(f, l, parser); }) && f == l;
 	}
 
 	// Attributes are given by the caller
@@ -53,7 +67,7 @@ namespace lac::helper
 		const auto l = input.end();
 		pos::Positions positions{f, l};
 		const auto parser = boost::spirit::x3::with<pos::position_tag>(std::ref(positions))[p];
-		return boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space, args...) && f == l;
+		return parse_or_fail([&] { return boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space, args...); }) && f == l;
 	}
 
 	// A dummy attribute is added
@@ -66,7 +80,7 @@ namespace lac::helper
 		const auto parser = boost::spirit::x3::with<pos::position_tag>(std::ref(positions))[p];
 
 		typename P::attribute_type val;
-		return boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space, val) && f == l;
+		return parse_or_fail([&] { return boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space, val); }) && f == l;
 	}
 
 	// The rule does not have an attribute
@@ -77,7 +91,7 @@ namespace lac::helper
 		const auto l = input.end();
 		pos::Positions positions{f, l};
 		const auto parser = boost::spirit::x3::with<pos::position_tag>(std::ref(positions))[p];
-		return boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space) && f == l;
+		return parse_or_fail([&] { return boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space); }) && f == l;
 	}
 
 	template <class P, class V>
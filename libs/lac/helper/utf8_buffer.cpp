@@ -0,0 +1,182 @@
+#include <lac/helper/utf8_buffer.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+
+namespace
+{
+	// Number of bytes of the UTF-8 sequence starting with this byte
+	size_t sequenceLength(char c)
+	{
+		const auto b = static_cast<unsigned char>(c);
+		if (b >= 0xF0)
+			return 4;
+		if (b >= 0xE0)
+			return 3;
+		if (b >= 0xC0)
+			return 2;
+		return 1;
+	}
+
+	// Number of UTF-16 code units for this UTF-8 sequence length
+	size_t utf16Length(size_t sequenceLength)
+	{
+		return sequenceLength == 4 ? 2 : 1;
+	}
+
+	size_t countUtf16(std::string_view text)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < text.size();)
+		{
+			const auto len = sequenceLength(text[i]);
+			count += utf16Length(len);
+			i += len;
+		}
+		return count;
+	}
+} // namespace
+
+namespace lac::helper
+{
+	void Utf8Buffer::assign(std::string text)
+	{
+		m_text = std::move(text);
+		m_lines = {Line{}};
+		m_utf16Size = 0;
+
+		for (size_t i = 0; i < m_text.size();)
+		{
+			const auto len = sequenceLength(m_text[i]);
+			m_utf16Size += utf16Length(len);
+			i += len;
+			if (m_text[i - len] == '\n')
+				m_lines.push_back({i, m_utf16Size});
+		}
+	}
+
+	void Utf8Buffer::replace(size_t utf16Position, size_t utf16Removed, std::string_view added)
+	{
+		utf16Position = std::min(utf16Position, m_utf16Size);
+		utf16Removed = std::min(utf16Removed, m_utf16Size - utf16Position);
+
+		const auto firstLine = lineAtUtf16(utf16Position);
+		const auto lastLine = lineAtUtf16(utf16Position + utf16Removed);
+		const auto begin = toUtf8(utf16Position);
+		const auto end = toUtf8(utf16Position + utf16Removed);
+		m_text.replace(begin, end - begin, added);
+
+		// Lines starting in the added text
+		std::vector<Line> newLines;
+		size_t utf16 = utf16Position;
+		for (size_t i = 0; i < added.size();)
+		{
+			const auto len = sequenceLength(added[i]);
+			utf16 += utf16Length(len);
+			i += len;
+			if (added[i - len] == '\n')
+				newLines.push_back({begin + i, utf16});
+		}
+
+		// Lines starting after the modification are only moved
+		const auto firstMoved = m_lines.begin() + lastLine + 1;
+		for (auto it = firstMoved; it != m_lines.end(); ++it)
+		{
+			it->utf8Start = it->utf8Start + added.size() - (end - begin);
+			it->utf16Start = it->utf16Start + (utf16 - utf16Position) - utf16Removed;
+		}
+
+		const auto eraseIt = m_lines.erase(m_lines.begin() + firstLine + 1, firstMoved);
+		m_lines.insert(eraseIt, newLines.begin(), newLines.end());
+		m_utf16Size = m_utf16Size + (utf16 - utf16Position) - utf16Removed;
+	}
+
+	std::string_view Utf8Buffer::view() const
+	{
+		return m_text;
+	}
+
+	size_t Utf8Buffer::utf16Size() const
+	{
+		return m_utf16Size;
+	}
+
+	size_t Utf8Buffer::toUtf8(size_t utf16Position) const
+	{
+		const auto& line = m_lines[lineAtUtf16(utf16Position)];
+		auto offset = line.utf8Start;
+		auto utf16 = line.utf16Start;
+		while (utf16 < utf16Position && offset < m_text.size())
+		{
+			const auto len = sequenceLength(m_text[offset]);
+			utf16 += utf16Length(len);
+			offset += len;
+		}
+		return std::min(offset, m_text.size());
+	}
+
+	size_t Utf8Buffer::toUtf16(size_t utf8Offset) const
+	{
+		utf8Offset = std::min(utf8Offset, m_text.size());
+		const auto it = std::upper_bound(m_lines.begin(), m_lines.end(), utf8Offset, [](size_t offset, const Line& line) {
+			return offset < line.utf8Start;
+		});
+		const auto& line = *(it - 1);
+		return line.utf16Start + countUtf16(std::string_view{m_text}.substr(line.utf8Start, utf8Offset - line.utf8Start));
+	}
+
+	size_t Utf8Buffer::lineAtUtf16(size_t utf16Position) const
+	{
+		const auto it = std::upper_bound(m_lines.begin(), m_lines.end(), utf16Position, [](size_t position, const Line& line) {
+			return position < line.utf16Start;
+		});
+		return (it - m_lines.begin()) - 1;
+	}
+
+	TEST_CASE("Utf8Buffer conversions")
+	{
+		// "é" is 2 bytes and 1 UTF-16 unit, "😀" is 4 bytes and 2 UTF-16 units
+		Utf8Buffer buffer;
+		buffer.assign("a = 'é'\nb = '😀'\nc = 1");
+		CHECK(buffer.utf16Size() == 22);
+
+		CHECK(buffer.toUtf8(0) == 0);
+		CHECK(buffer.toUtf8(5) == 5);
+		CHECK(buffer.toUtf8(6) == 7);
+		CHECK(buffer.toUtf8(8) == 9);   // Start of the second line
+		CHECK(buffer.toUtf8(17) == 20); // Start of the third line
+		CHECK(buffer.toUtf8(22) == 25);
+
+		CHECK(buffer.toUtf16(7) == 6);
+		CHECK(buffer.toUtf16(18) == 15);
+		CHECK(buffer.toUtf16(20) == 17);
+		CHECK(buffer.toUtf16(25) == 22);
+	}
+
+	TEST_CASE("Utf8Buffer modifications")
+	{
+		Utf8Buffer buffer;
+		buffer.assign("a = 'é'\nb = 2\nc = 3");
+
+		// Insert a new line containing a non-ASCII character
+		buffer.replace(8, 0, "ü = 1\n");
+		CHECK(buffer.view() == "a = 'é'\nü = 1\nb = 2\nc = 3");
+		CHECK(buffer.toUtf8(14) == 16);
+		CHECK(buffer.toUtf16(16) == 14);
+		CHECK(buffer.toUtf8(20) == 22);
+
+		// Remove two lines
+		buffer.replace(7, 12, "");
+		CHECK(buffer.view() == "a = 'é'\nc = 3");
+		CHECK(buffer.utf16Size() == 13);
+		CHECK(buffer.toUtf8(8) == 9);
+		CHECK(buffer.toUtf16(9) == 8);
+
+		// Same result as assigning the whole text
+		Utf8Buffer other;
+		other.assign(std::string{buffer.view()});
+		for (size_t i = 0; i <= buffer.utf16Size(); ++i)
+			CHECK(buffer.toUtf8(i) == other.toUtf8(i));
+	}
+} // namespace lac::helper
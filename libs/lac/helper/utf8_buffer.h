@@ -0,0 +1,37 @@
+#pragma once
+
+#include <lac/core_api.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lac::helper
+{
+	// UTF-8 text that can be modified using UTF-16 positions (as used by Qt).
+	// The start of each line is stored in both encodings, so that converting a position only has to look at one line.
+	class CORE_API Utf8Buffer
+	{
+	public:
+		void assign(std::string text);
+		void replace(size_t utf16Position, size_t utf16Removed, std::string_view added);
+
+		std::string_view view() const;
+		size_t utf16Size() const;
+
+		size_t toUtf8(size_t utf16Position) const;
+		size_t toUtf16(size_t utf8Offset) const;
+
+	private:
+		struct Line
+		{
+			size_t utf8Start = 0, utf16Start = 0;
+		};
+
+		size_t lineAtUtf16(size_t utf16Position) const; // Index of the line containing this position
+
+		std::string m_text;
+		std::vector<Line> m_lines = {Line{}};
+		size_t m_utf16Size = 0;
+	};
+} // namespace lac::helper
@@ -0,0 +1,359 @@
+#include <lac/parser/ast_adapted.h>
+#include <lac/parser/binary_ast.h>
+#include <lac/parser/parser.h>
+#include <lac/helper/binary_stream.h>
+
+#ifdef WITH_NLOHMANN_JSON
+#include <lac/parser/printer.h>
+#endif
+
+#include <boost/fusion/include/for_each.hpp>
+#include <boost/fusion/support/is_sequence.hpp>
+
+#include <doctest/doctest.h>
+
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	constexpr std::string_view magic = "LACB";
+	constexpr uint64_t version = 1; // Must be incremented each time the AST or the format changes
+
+	namespace x3 = boost::spirit::x3;
+
+	// Also true for the types deriving from a variant
+	template <class T>
+	struct is_variant
+	{
+		template <class... Types>
+		static std::true_type test(const x3::variant<Types...>*);
+		static std::false_type test(...);
+
+		static constexpr bool value = decltype(test(std::declval<T*>()))::value;
+	};
+
+	template <class T>
+	constexpr bool is_variant_v = is_variant<T>::value;
+
+	template <class T>
+	struct is_vector : std::false_type
+	{
+	};
+
+	template <class T>
+	struct is_vector<std::vector<T>> : std::true_type
+	{
+	};
+
+	template <class T>
+	struct is_optional : std::false_type
+	{
+	};
+
+	template <class T>
+	struct is_optional<boost::optional<T>> : std::true_type
+	{
+	};
+
+	template <class T>
+	struct is_forward_ast : std::false_type
+	{
+	};
+
+	template <class T>
+	struct is_forward_ast<x3::forward_ast<T>> : std::true_type
+	{
+	};
+
+	// Invalid values could make the users of the AST crash
+	template <class T>
+	constexpr uint64_t maxEnumValue()
+	{
+		using namespace lac::ast;
+		if constexpr (std::is_same_v<T, Operation>)
+			return static_cast<uint64_t>(Operation::lor);
+		else if constexpr (std::is_same_v<T, ExpressionConstant>)
+			return static_cast<uint64_t>(ExpressionConstant::True);
+		else
+		{
+			static_assert(std::is_same_v<T, ElementType>, "Enum not supported");
+			return static_cast<uint64_t>(ElementType::member_function);
+		}
+	}
+
+	// The AST is written by following the adapted structures and the variants.
+	// Variants are prefixed by the index of their type, vectors by their size, and optionals by a flag.
+	class AstWriter
+	{
+	public:
+		AstWriter(std::string& buffer)
+			: m_writer(buffer)
+		{
+		}
+
+		template <class T>
+		void write(const T& value)
+		{
+			if constexpr (lac::pos::is_position_annotated<T>)
+			{
+				m_writer.writeUnsigned(value.begin);
+				m_writer.writeUnsigned(value.end);
+			}
+
+			if constexpr (is_variant_v<T>)
+			{
+				const auto& variant = value.get();
+				m_writer.writeUnsigned(variant.which());
+				boost::apply_visitor([this](const auto& v) { write(v); }, variant);
+			}
+			else if constexpr (boost::fusion::traits::is_sequence<T>::value)
+				boost::fusion::for_each(value, [this](const auto& member) { write(member); });
+			else if constexpr (std::is_same_v<T, std::string>)
+				m_writer.writeString(value);
+			else if constexpr (is_vector<T>::value)
+			{
+				m_writer.writeUnsigned(value.size());
+				for (const auto& item : value)
+					write(item);
+			}
+			else if constexpr (is_optional<T>::value)
+			{
+				m_writer.writeByte(value ? 1 : 0);
+				if (value)
+					write(*value);
+			}
+			else if constexpr (is_forward_ast<T>::value)
+				write(value.get());
+			else if constexpr (std::is_same_v<T, bool>)
+				m_writer.writeByte(value ? 1 : 0);
+			else if constexpr (std::is_enum_v<T>)
+				m_writer.writeUnsigned(static_cast<uint64_t>(value));
+			else if constexpr (std::is_same_v<T, int>)
+				m_writer.writeSigned(value);
+			else if constexpr (std::is_same_v<T, double>)
+				m_writer.writeDouble(value);
+			else
+				static_assert(std::is_empty_v<T>, "Type not supported");
+		}
+
+		void writeElements(const lac::pos::Elements& elements)
+		{
+			// Elements are close to each other, so we only write the difference with the previous one
+			m_writer.writeUnsigned(elements.size());
+			size_t previous = 0;
+			for (const auto& elt : elements)
+			{
+				m_writer.writeUnsigned(static_cast<uint64_t>(elt.type));
+				m_writer.writeSigned(static_cast<int64_t>(elt.begin) - static_cast<int64_t>(previous));
+				m_writer.writeUnsigned(elt.end - elt.begin);
+				previous = elt.begin;
+			}
+		}
+
+	private:
+		lac::helper::BinaryWriter m_writer;
+	};
+
+	class AstReader
+	{
+	public:
+		AstReader(lac::helper::BinaryReader& reader)
+			: m_reader(reader)
+		{
+		}
+
+		template <class T>
+		void read(T& value)
+		{
+			if (!m_reader.ok())
+				return;
+
+			if constexpr (lac::pos::is_position_annotated<T>)
+			{
+				value.begin = static_cast<size_t>(m_reader.readUnsigned());
+				value.end = static_cast<size_t>(m_reader.readUnsigned());
+			}
+
+			if constexpr (is_variant_v<T>)
+				readVariant(value);
+			else if constexpr (boost::fusion::traits::is_sequence<T>::value)
+				boost::fusion::for_each(value, [this](auto& member) { read(member); });
+			else if constexpr (std::is_same_v<T, std::string>)
+				value = m_reader.readString();
+			else if constexpr (is_vector<T>::value)
+			{
+				// Each item takes at least one byte, this prevents allocating too much memory with invalid data
+				const auto size = m_reader.readUnsigned();
+				if (size > m_reader.remaining())
+				{
+					m_reader.fail();
+					return;
+				}
+
+				value.resize(static_cast<size_t>(size));
+				for (auto& item : value)
+					read(item);
+			}
+			else if constexpr (is_optional<T>::value)
+			{
+				if (m_reader.readByte())
+				{
+					value.emplace();
+					read(*value);
+				}
+				else
+					value.reset();
+			}
+			else if constexpr (is_forward_ast<T>::value)
+				read(value.get());
+			else if constexpr (std::is_same_v<T, bool>)
+				value = m_reader.readByte() != 0;
+			else if constexpr (std::is_enum_v<T>)
+				value = readEnum<T>();
+			else if constexpr (std::is_same_v<T, int>)
+				value = static_cast<int>(m_reader.readSigned());
+			else if constexpr (std::is_same_v<T, double>)
+				value = m_reader.readDouble();
+			else
+				static_assert(std::is_empty_v<T>, "Type not supported");
+		}
+
+		void readElements(lac::pos::Elements& elements)
+		{
+			const auto size = m_reader.readUnsigned();
+			if (size > m_reader.remaining())
+			{
+				m_reader.fail();
+				return;
+			}
+
+			elements.resize(static_cast<size_t>(size));
+			size_t previous = 0;
+			for (auto& elt : elements)
+			{
+				elt.type = readEnum<lac::ast::ElementType>();
+				elt.begin = previous + static_cast<size_t>(m_reader.readSigned());
+				elt.end = elt.begin + static_cast<size_t>(m_reader.readUnsigned());
+				previous = elt.begin;
+			}
+		}
+
+	private:
+		template <class T>
+		T readEnum()
+		{
+			const auto value = m_reader.readUnsigned();
+			if (value > maxEnumValue<T>())
+			{
+				m_reader.fail();
+				return {};
+			}
+			return static_cast<T>(value);
+		}
+
+		template <class... Types>
+		void readVariant(x3::variant<Types...>& variant)
+		{
+			const auto index = m_reader.readUnsigned();
+			size_t i = 0;
+			const bool found = ((i++ == index ? (readAlternative<Types>(variant), true) : false) || ...);
+			if (!found)
+				m_reader.fail();
+		}
+
+		template <class T, class Variant>
+		void readAlternative(Variant& variant)
+		{
+			T value{};
+			read(value);
+			variant = std::move(value);
+		}
+
+		lac::helper::BinaryReader& m_reader;
+	};
+} // namespace
+
+namespace lac
+{
+	void writeBinary(std::string& buffer, const ast::Block& block, const pos::Elements& elements)
+	{
+		helper::BinaryWriter header{buffer};
+		header.writeRaw(magic);
+		header.writeUnsigned(version);
+
+		AstWriter writer{buffer};
+		writer.write(block);
+		writer.writeElements(elements);
+	}
+
+	BinaryBlock readBinary(std::string_view data)
+	{
+		BinaryBlock result;
+		helper::BinaryReader reader{data};
+		if (reader.readRaw(magic.size()) != magic || reader.readUnsigned() != version)
+			return result;
+
+		AstReader astReader{reader};
+		astReader.read(result.block);
+		astReader.readElements(result.elements);
+		result.valid = reader.ok() && !reader.remaining();
+		return result;
+	}
+
+	TEST_CASE("Binary AST")
+	{
+		const std::string program = R"~~(
+-- Comment
+local a, b = 42, -3.5e3
+local t = { x = 1, [a] = "text", 2.0; y = { } }
+function t.f:g(x, y, ...)
+	if x > y then return x elseif x == y then return else return -y end
+end
+while a < 10 do a = a + 1 end
+repeat b = b // 2 until not (b >= 1)
+for i = 1, 10, 2 do print(i, t[i], t.x:len()) end
+for k, v in pairs(t) do ::continue:: goto continue end
+do local function f() return ... end break end
+print "text" (t) { 1 }
+)~~";
+
+		const auto ret = parser::parseBlock(program);
+		REQUIRE(ret.parsed);
+		const auto elements = ret.positions.elements();
+
+		std::string buffer;
+		writeBinary(buffer, ret.block, elements);
+		CHECK(buffer.size() < program.size() * 2);
+
+		const auto restored = readBinary(buffer);
+		REQUIRE(restored.valid);
+#ifdef WITH_NLOHMANN_JSON
+		CHECK(toJson(restored.block) == toJson(ret.block));
+#endif
+		CHECK(restored.block.begin == ret.block.begin);
+		CHECK(restored.block.end == ret.block.end);
+
+		REQUIRE(restored.elements.size() == elements.size());
+		for (size_t i = 0; i < elements.size(); ++i)
+		{
+			CHECK(restored.elements[i].begin == elements[i].begin);
+			CHECK(restored.elements[i].end == elements[i].end);
+			CHECK(restored.elements[i].type == elements[i].type);
+		}
+
+		// Writing again gives the same data
+		std::string second;
+		writeBinary(second, restored.block, restored.elements);
+		CHECK(second == buffer);
+
+		// Invalid data
+		CHECK_FALSE(readBinary("").valid);
+		CHECK_FALSE(readBinary(buffer.substr(0, buffer.size() / 2)).valid);
+		CHECK_FALSE(readBinary(buffer + "x").valid);
+
+		auto otherVersion = buffer;
+		otherVersion[magic.size()] = static_cast<char>(version + 1);
+		CHECK_FALSE(readBinary(otherVersion).valid);
+	}
+} // namespace lac
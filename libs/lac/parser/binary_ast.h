@@ -0,0 +1,24 @@
+#pragma once
+
+#include <lac/parser/ast.h>
+#include <lac/parser/positions.h>
+#include <lac/core_api.h>
+
+#include <string>
+#include <string_view>
+
+namespace lac
+{
+	// Compact serialization of a parsed program and its elements, to cache it or to send it to another process.
+	// The data begins with the version of the format, and is rejected when read by another version.
+	CORE_API void writeBinary(std::string& buffer, const ast::Block& block, const pos::Elements& elements);
+
+	struct CORE_API BinaryBlock
+	{
+		bool valid = false;
+		ast::Block block;
+		pos::Elements elements;
+	};
+
+	CORE_API BinaryBlock readBinary(std::string_view data);
+} // namespace lac
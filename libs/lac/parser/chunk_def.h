@@ -52,16 +52,21 @@
 	unop ::= '-' | not | '#' | '~'
 */
 
-namespace lac::parser
+// The same grammar is compiled without attributes in validation.cpp, to only check the syntax without creating the AST
+#ifdef LAC_VALIDATION_GRAMMAR
+#define LAC_GRAMMAR_NAMESPACE lac::parser::validation
+#else
+#define LAC_GRAMMAR_NAMESPACE lac::parser
+#endif
+
+namespace LAC_GRAMMAR_NAMESPACE
 {
 	namespace x3 = boost::spirit::x3;
-	namespace ascii = x3::ascii;
-	using ascii::char_;
-	using ascii::string;
+	namespace standard = x3::standard; // Accepts all 8 bits, so UTF-8 can be used in strings and comments
+	using standard::char_;
+	using standard::string;
 	using x3::_attr;
 	using x3::_pass;
-	using x3::alnum;
-	using x3::alpha;
 	using x3::double_;
 	using x3::eol;
 	using x3::get;
@@ -102,7 +107,7 @@ namespace lac::parser
 					("until", "until")
 					("while", "while");
 			}
-		} keyword;
+		} const keyword;
 
 		struct binaryOperator_ : x3::symbols<ast::Operation>
 		{
@@ -132,7 +137,7 @@ namespace lac::parser
 					("and", Op::land)
 					("or", Op::lor);
 			}
-		} binaryOperator;
+		} const binaryOperator;
 
 		struct unaryOperator_ : x3::symbols<ast::Operation>
 		{
@@ -145,7 +150,7 @@ namespace lac::parser
 					("~", Op::bnot)
 					("not", Op::lnot);
 			}
-		} unaryOperator;
+		} const unaryOperator;
 
 		struct expressionConstant_ : x3::symbols<ast::ExpressionConstant>
 		{
@@ -158,14 +163,20 @@ namespace lac::parser
 					("true", EC::True)
 					("...", EC::dots);
 			}
-		} expressionConstant;
+		} const expressionConstant;
 	// clang-format on
 
+#ifdef LAC_VALIDATION_GRAMMAR
+#define RULE(name, type) \
+	struct name;         \
+	const x3::rule<struct name> name = #name;
+#else
 #define RULE(name, type)                 \
 	struct name : pos::annotate_position \
 	{                                    \
 	};                                   \
 	const x3::rule<struct name, type> name = #name;
+#endif
 
 	RULE(name, std::string)
 	RULE(namesList, std::vector<std::string>)
@@ -242,43 +253,30 @@ namespace lac::parser
 
 #undef RULE
 
-	// To annotate rules with no struct attributes
-	struct element_tag
-	{
-	};
-	auto startElement = [](auto& ctx) {
-		if constexpr (pos::has_tag<decltype(ctx), pos::position_tag>)
-		{
-			auto& positions = x3::get<pos::position_tag>(ctx).get();
-			auto& elt = get<element_tag>(ctx);
-			elt.begin = positions.pos(_where(ctx).begin());
-		}
-	};
-	auto endElement = [](auto& ctx) {
+	// To annotate rules with no struct attributes, used as the action of raw[]
+	template <ast::ElementType type>
+	const auto addElement = [](auto& ctx) {
 		if constexpr (pos::has_tag<decltype(ctx), pos::position_tag>)
 		{
 			auto& positions = x3::get<pos::position_tag>(ctx).get();
-			auto& elt = get<element_tag>(ctx);
-			elt.end = positions.pos(_where(ctx).begin());
+			pos::Element elt{type};
+			elt.begin = positions.pos(_attr(ctx).begin());
+			elt.end = positions.pos(_attr(ctx).end());
 			positions.addElement(elt);
 		}
 	};
 
-	const x3::rule<class elementStart> elementStart = "elementStart";
-	const x3::rule<class elementEnd> elementEnd = "elementEnd";
-	const auto elementStart_def = x3::eps[startElement];
-	const auto elementEnd_def = x3::eps[endElement];
-
 	// Names
-	const auto nameFirstLetter = alpha | char_('_');
-	const auto nameLetter = alnum | char_('_');
+	// Lua names only use ASCII letters, this does not depend on the locale
+	const auto nameFirstLetter = char_('a', 'z') | char_('A', 'Z') | char_('_');
+	const auto nameLetter = nameFirstLetter | char_('0', '9');
 	const auto name_def = lexeme[(nameFirstLetter >> *nameLetter)
 								 - (keyword >> !nameLetter)];
 
 	const auto namesList_def = name % ',';
 
 	// Short literal strings
-	auto quotedString = [](char c) {
+	const auto quotedString = [](char c) {
 		return lit(c)
 			   >> *(('\\' >> char_(c)) // Escaped quote
 					| (char_ - c))     // Any character but the quote
@@ -289,8 +287,8 @@ namespace lac::parser
 	struct long_bracket_tag
 	{
 	};
-	auto set_bracket = [](auto& ctx) { get<long_bracket_tag>(ctx) = _attr(ctx); };
-	auto is_bracket = [](auto& ctx) { _pass(ctx) = (get<long_bracket_tag>(ctx) == _attr(ctx)); };
+	const auto set_bracket = [](auto& ctx) { get<long_bracket_tag>(ctx) = _attr(ctx); };
+	const auto is_bracket = [](auto& ctx) { _pass(ctx) = (get<long_bracket_tag>(ctx) == _attr(ctx)); };
 	const auto openLongBracket_def = '[' >> (*char_('='))[set_bracket] >> '[';
 	const auto closeLongBacket_def = ']' >> (*char_('='))[is_bracket] >> ']';
 	const auto longLiteralString_def = with<long_bracket_tag>(std::string())
@@ -321,22 +319,27 @@ namespace lac::parser
 	const auto comment_def = longComment | shortComment;
 
 	// Keywords
-	auto kwd = [](const char* str) {
-		return with<element_tag>(pos::Element{ast::ElementType::keyword})
-			[omit[elementStart]
-			 >> omit[x3::string(str)]
-			 >> x3::no_skip[omit[elementEnd]]];
+	// A rule named after the keyword, for the error messages of the expectation points
+	struct keywordRule
+	{
+	};
+	const auto kwd = [](const char* str) {
+		return x3::rule<keywordRule>{str} = raw[lexeme[lit(str) >> !nameLetter]] // Not the beginning of a longer name
+													  [addElement<ast::ElementType::keyword>];
 	};
 
 	// A skipper that ignore whitespace and comments
+	struct skipper; // Not the one of chunk.h when compiling the validation grammar
 	const x3::rule<struct skipper> skipper = "skipper";
-	const auto skipper_def = ascii::space
-							 | with<element_tag>(pos::Element{ast::ElementType::comment})
-								   [x3::no_skip[omit[elementStart >> comment >> elementEnd]]];
+	const auto whitespace = char_(" \t\n\r\v\f");
+	const auto skipper_def = whitespace
+							 | x3::no_skip[raw[comment][addElement<ast::ElementType::comment>]];
 
 	//*** Complete syntax of Lua ***
+	// The expectation points (>) are only placed where no other rule can match, as they prevent backtracking.
+	// Their failures are converted to diagnostics by the parser.
 	// Table and fields
-	const auto fieldByExpression_def = '[' >> expression >> lit(']') >> lit('=') >> expression;
+	const auto fieldByExpression_def = '[' >> expression >> lit(']') >> lit('=') > expression; // '[' can also start a long string
 	const auto fieldByAssignment_def = name >> '=' >> expression;
 	const auto field_def = fieldByExpression
 						   | fieldByAssignment
@@ -345,7 +348,7 @@ namespace lac::parser
 	const auto fieldSeparator = lit(',') | lit(';');
 	const auto fieldsList_def = field >> *(fieldSeparator >> field) >> -fieldSeparator;
 
-	const auto tableConstructor_def = '{' >> -fieldsList >> '}';
+	const auto tableConstructor_def = '{' > -fieldsList > '}';
 
 	// Functions
 	const auto funcVarargs = lit("...") >> x3::attr(true);
@@ -353,15 +356,15 @@ namespace lac::parser
 									| (x3::attr(ast::NamesList{}) >> funcVarargs);
 
 	const auto emptyArguments = lit('(') >> lit(')') >> x3::attr(ast::EmptyArguments());
-	const auto argumentsExpressions = '(' >> expressionsList >> ')';
+	const auto argumentsExpressions = '(' >> expressionsList > ')';
 	const auto arguments_def = emptyArguments
 							   | argumentsExpressions
 							   | tableConstructor
 							   | literalString;
 
-	const auto functionBody_def = '(' >> -parametersList >> ')' >> block >> kwd("end");
+	const auto functionBody_def = '(' > -parametersList > ')' > block > kwd("end");
 
-	const auto functionDefinition_def = kwd("function") >> functionBody;
+	const auto functionDefinition_def = kwd("function") > functionBody;
 
 	const auto functionCallPostfix_def = -(tableIndexExpression
 										   | tableIndexName)
@@ -378,7 +381,7 @@ namespace lac::parser
 	const auto functionName_def = name >> *('.' >> name) >> -functionNameMember;
 
 	// Variables
-	const auto bracketedExpression_def = '(' >> expression >> ')';
+	const auto bracketedExpression_def = '(' > expression > ')';
 	const auto tableIndexExpression_def = '[' >> expression >> ']';
 	const auto tableIndexName_def = '.' >> name;
 	const auto prefixExpression_def = (bracketedExpression
@@ -422,26 +425,26 @@ namespace lac::parser
 
 	// Statements
 	const auto emptyStatement = lit(';') >> x3::attr(ast::EmptyStatement{});
-	const auto assignmentStatement_def = variablesList >> '=' >> expressionsList;
-	const auto labelStatement_def = "::" >> name >> "::";
-	const auto gotoStatement_def = kwd("goto") >> name;
+	const auto assignmentStatement_def = variablesList >> '=' > expressionsList;
+	const auto labelStatement_def = "::" > name > "::";
+	const auto gotoStatement_def = kwd("goto") > name;
 	const auto breakStatement_def = kwd("break") >> x3::attr(ast::BreakStatement{});
-	const auto doStatement_def = kwd("do") >> block >> kwd("end");
-	const auto whileStatement_def = kwd("while") >> expression >> kwd("do") >> block >> kwd("end");
-	const auto repeatStatement_def = kwd("repeat") >> block >> kwd("until") >> expression;
-	const auto ifStatement_def = kwd("if") >> expression >> kwd("then") >> block;
-	const auto elseIfStatement_def = kwd("elseif") >> expression >> kwd("then") >> block;
+	const auto doStatement_def = kwd("do") > block > kwd("end");
+	const auto whileStatement_def = kwd("while") > expression > kwd("do") > block > kwd("end");
+	const auto repeatStatement_def = kwd("repeat") > block > kwd("until") > expression;
+	const auto ifStatement_def = kwd("if") > expression > kwd("then") > block;
+	const auto elseIfStatement_def = kwd("elseif") > expression > kwd("then") > block;
 	const auto ifThenElseStatement_def = ifStatement
 										 >> *(elseIfStatement)
-										 >> -(kwd("else") >> block)
-										 >> kwd("end");
-	const auto numericalForStatement_def = kwd("for") >> name >> '=' >> expression
-										   >> ',' >> expression >> -(',' >> expression)
-										   >> kwd("do") >> block >> kwd("end");
-	const auto genericForStatement_def = kwd("for") >> namesList >> kwd("in") >> expressionsList >> kwd("do") >> block >> kwd("end");
-	const auto functionDeclarationStatement_def = kwd("function") >> functionName >> functionBody;
-	const auto localFunctionDeclarationStatement_def = kwd("local") >> kwd("function") >> name >> functionBody;
-	const auto localAssignmentStatement_def = kwd("local") >> namesList >> -('=' >> expressionsList);
+										 >> -(kwd("else") > block)
+										 > kwd("end");
+	const auto numericalForStatement_def = kwd("for") >> name >> '=' > expression
+										   > ',' > expression > -(',' > expression)
+										   > kwd("do") > block > kwd("end");
+	const auto genericForStatement_def = kwd("for") > namesList > kwd("in") > expressionsList > kwd("do") > block > kwd("end"); // Tried after the numerical for
+	const auto functionDeclarationStatement_def = kwd("function") > functionName > functionBody;
+	const auto localFunctionDeclarationStatement_def = kwd("local") >> kwd("function") > name > functionBody;
+	const auto localAssignmentStatement_def = kwd("local") > namesList > -('=' > expressionsList); // Tried after the local function
 
 	const auto statement_def = emptyStatement
 							   | assignmentStatement
@@ -470,7 +473,6 @@ namespace lac::parser
 						longLiteralString, literalStringValue, literalString,
 						numeralInt, numeralFloat, numeral,
 						shortComment, longComment, comment,
-						elementStart, elementEnd,
 						skipper,
 						fieldByExpression, fieldByAssignment, field, fieldsList, tableConstructor,
 						parametersList, arguments,
@@ -490,19 +492,6 @@ namespace lac::parser
 						functionDeclarationStatement, localFunctionDeclarationStatement,
 						returnStatement, statement,
 						block, chunk)
+} // namespace LAC_GRAMMAR_NAMESPACE
 
-	skipper_type skipperRule()
-	{
-		return skipper;
-	}
-
-	chunk_type chunkRule()
-	{
-		return chunk;
-	}
-
-	variable_or_function_type variableOrFunctionRule()
-	{
-		return variableOrFunction;
-	}
-} // namespace lac::parser
+#undef LAC_GRAMMAR_NAMESPACE
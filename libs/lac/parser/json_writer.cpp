@@ -0,0 +1,828 @@
+#include <lac/parser/json_writer.h>
+#include <lac/parser/parser.h>
+
+#ifdef WITH_NLOHMANN_JSON
+#include <lac/parser/printer.h>
+#endif
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <ostream>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+	constexpr size_t chunkSize = 64 * 1024; // When writing to a stream
+} // namespace
+
+namespace lac
+{
+	using namespace ast;
+
+	class JsonWriter
+	{
+	public:
+		JsonWriter(std::string& out, bool withPositions, std::ostream* stream = nullptr)
+			: m_out(out)
+			, m_stream(stream)
+			, m_withPositions(withPositions)
+		{
+		}
+
+		void flush()
+		{
+			if (m_stream)
+			{
+				m_stream->write(m_out.data(), m_out.size());
+				m_out.clear();
+			}
+		}
+
+		void write(ExpressionConstant ec)
+		{
+			static const char* constants[] = {"nil", "...", "false", "true"};
+
+			beginObject("ExpressionConstant");
+			key("contant"); // Same key as the printer
+			string(constants[static_cast<int>(ec)]);
+			endObject();
+		}
+
+		void write(const LiteralString& ls)
+		{
+			beginObject("LiteralString", &ls);
+			key("value");
+			string(ls.value);
+			endObject();
+		}
+
+		void write(int v)
+		{
+			beginObject("Numeral");
+			key("value");
+			number(v);
+			endObject();
+		}
+
+		void write(double v)
+		{
+			beginObject("Numeral");
+			key("value");
+			number(v);
+			endObject();
+		}
+
+		void write(const std::string& v)
+		{
+			beginObject("Name");
+			key("value");
+			string(v);
+			endObject();
+		}
+
+		void write(const NamesList& list)
+		{
+			beginObject("NamesList");
+			if (!list.empty())
+				stringArray("names", list);
+			endObject();
+		}
+
+		void write(const Numeral& n)
+		{
+			beginObject("Numeral", &n);
+			key("value");
+			if (n.isInt())
+				number(n.asInt());
+			else
+				number(n.asFloat());
+			endObject();
+		}
+
+		void write(const Operand& operand)
+		{
+			// The operand does not have its own object, its position is added to the object of its value
+			m_operandPosition = &operand;
+			visit(operand);
+		}
+
+		void write(const Field& field)
+		{
+			visit(field);
+		}
+
+		void write(const PostPrefix& post)
+		{
+			visit(post);
+		}
+
+		void write(const VariablePostfix& post)
+		{
+			visit(post);
+		}
+
+		void write(const UnaryOperation& uo)
+		{
+			beginObject("UnaryOperation");
+			key("operator");
+			string(getString(uo.operation));
+			key("argument");
+			write(uo.expression);
+			endObject();
+		}
+
+		void write(const BinaryOperation& bo)
+		{
+			beginObject("BinaryOperation");
+			key("operator");
+			string(getString(bo.operation));
+			key("argument");
+			write(bo.expression);
+			endObject();
+		}
+
+		void write(const BracketedExpression& be)
+		{
+			beginObject("BracketedExpression");
+			key("expression");
+			write(be.expression);
+			endObject();
+		}
+
+		void write(const TableIndexExpression& tie)
+		{
+			beginObject("TableIndexExpression");
+			key("expression");
+			write(tie.expression);
+			endObject();
+		}
+
+		void write(const TableIndexName& tin)
+		{
+			beginObject("TableIndexName");
+			key("name");
+			string(tin.name);
+			endObject();
+		}
+
+		void write(const ExpressionsList& list)
+		{
+			beginObject("ExpressionsList");
+			array("expressions", list);
+			endObject();
+		}
+
+		void write(const EmptyArguments&)
+		{
+			beginObject("EmptyArguments");
+			endObject();
+		}
+
+		void write(const FunctionCallEnd& fce)
+		{
+			beginObject("FunctionCallEnd", &fce);
+			if (fce.member)
+			{
+				key("member");
+				string(*fce.member);
+			}
+			key("arguments");
+			visit(fce.arguments);
+			endObject();
+		}
+
+		void write(const VariableFunctionCall& vfc)
+		{
+			beginObject("VariableFunctionCall");
+			key("call");
+			write(vfc.functionCall);
+			key("post");
+			visit(vfc.postVariable);
+			endObject();
+		}
+
+		void write(const Variable& v)
+		{
+			beginObject("Variable", &v);
+			key("start");
+			visit(v.start);
+			if (!v.rest.empty())
+				array("rest", v.rest);
+			endObject();
+		}
+
+		void write(const Expression& ex)
+		{
+			beginObject("Expression");
+			key("left");
+			write(ex.operand);
+			if (ex.binaryOperation)
+			{
+				key("right");
+				write(ex.binaryOperation->get());
+			}
+			endObject();
+		}
+
+		void write(const FieldByExpression& fbe)
+		{
+			beginObject("FieldByExpression");
+			key("key");
+			write(fbe.key);
+			key("value");
+			write(fbe.value);
+			endObject();
+		}
+
+		void write(const FieldByAssignment& fba)
+		{
+			beginObject("FieldByAssignment");
+			key("name");
+			write(fba.name);
+			key("value");
+			write(fba.value);
+			endObject();
+		}
+
+		void write(const FieldsList& list)
+		{
+			beginObject("FieldsList");
+			if (!list.empty())
+				array("fields", list);
+			endObject();
+		}
+
+		void write(const TableConstructor& tc)
+		{
+			beginObject("TableConstructor");
+			if (tc.fields)
+			{
+				key("fields");
+				write(*tc.fields);
+			}
+			endObject();
+		}
+
+		void write(const PrefixExpression& pe)
+		{
+			beginObject("PrefixExpression");
+			key("start");
+			visit(pe.start);
+			if (!pe.rest.empty())
+				array("rest", pe.rest);
+			endObject();
+		}
+
+		void write(const ParametersList& list)
+		{
+			beginObject("ParametersList");
+			if (!list.parameters.empty())
+				stringArray("parameters", list.parameters);
+			key("varargs");
+			separator();
+			m_out += list.varargs ? "true" : "false";
+			endObject();
+		}
+
+		void write(const FunctionBody& fb)
+		{
+			beginObject("Function body");
+			if (fb.parameters)
+			{
+				key("parameters");
+				write(*fb.parameters);
+			}
+			key("body");
+			write(fb.block);
+			endObject();
+		}
+
+		void write(const EmptyStatement&)
+		{
+			beginObject("EmptyStatement");
+			endObject();
+		}
+
+		void write(const AssignmentStatement& s)
+		{
+			beginObject("AssignmentStatement");
+			array("left", s.variables);
+			array("right", s.expressions);
+			endObject();
+		}
+
+		void write(const FunctionCallPostfix& fcp)
+		{
+			beginObject(nullptr);
+			if (fcp.tableIndex)
+			{
+				key("index");
+				visit(*fcp.tableIndex);
+			}
+			key("call");
+			write(fcp.functionCall);
+			endObject();
+		}
+
+		void write(const FunctionCall& fc)
+		{
+			beginObject("FunctionCall");
+			key("start");
+			visit(fc.start);
+			if (!fc.rest.empty())
+				array("rest", fc.rest);
+			endObject();
+		}
+
+		void write(const LabelStatement& s)
+		{
+			beginObject("LabelStatement");
+			key("name");
+			string(s.name);
+			endObject();
+		}
+
+		void write(const GotoStatement& s)
+		{
+			beginObject("GotoStatement");
+			key("label");
+			string(s.label);
+			endObject();
+		}
+
+		void write(const BreakStatement&)
+		{
+			beginObject("BreakStatement");
+			endObject();
+		}
+
+		void write(const DoStatement& s)
+		{
+			beginObject("DoStatement");
+			key("body");
+			write(s.block);
+			endObject();
+		}
+
+		void write(const WhileStatement& s)
+		{
+			beginObject("WhileStatement");
+			key("test");
+			write(s.condition);
+			key("body");
+			write(s.block);
+			endObject();
+		}
+
+		void write(const RepeatStatement& s)
+		{
+			beginObject("RepeatStatement");
+			key("test");
+			write(s.condition);
+			key("body");
+			write(s.block);
+			endObject();
+		}
+
+		void write(const IfStatement& s)
+		{
+			beginObject("IfStatement");
+			key("test");
+			write(s.condition);
+			key("body");
+			write(s.block);
+			endObject();
+		}
+
+		void write(const IfThenElseStatement& s)
+		{
+			beginObject("IfThenElseStatement");
+			key("first");
+			write(s.first);
+			if (!s.rest.empty())
+				array("rest", s.rest);
+			if (s.elseBlock)
+			{
+				key("alternate");
+				write(*s.elseBlock);
+			}
+			endObject();
+		}
+
+		void write(const NumericalForStatement& s)
+		{
+			beginObject("NumericalForStatement");
+			key("variable");
+			string(s.variable);
+			key("first");
+			write(s.first);
+			key("last");
+			write(s.last);
+			if (s.step)
+			{
+				key("step");
+				write(*s.step);
+			}
+			key("body");
+			write(s.block);
+			endObject();
+		}
+
+		void write(const GenericForStatement& s)
+		{
+			beginObject("GenericForStatement");
+			key("variables");
+			write(s.variables);
+			key("expressions");
+			write(s.expressions);
+			key("body");
+			write(s.block);
+			endObject();
+		}
+
+		void write(const FunctionName& fn)
+		{
+			beginObject("FunctionName");
+			key("start");
+			string(fn.start);
+			if (!fn.rest.empty())
+				stringArray("rest", fn.rest);
+			if (fn.member)
+			{
+				key("member");
+				string(fn.member->name);
+			}
+			endObject();
+		}
+
+		void write(const FunctionDeclarationStatement& s)
+		{
+			beginObject("FunctionDeclarationStatement");
+			key("name");
+			write(s.name);
+			key("body");
+			write(s.body);
+			endObject();
+		}
+
+		void write(const LocalFunctionDeclarationStatement& s)
+		{
+			beginObject("LocalFunctionDeclarationStatement");
+			key("name");
+			write(s.name);
+			key("body");
+			write(s.body);
+			endObject();
+		}
+
+		void write(const LocalAssignmentStatement& s)
+		{
+			beginObject("LocalAssignmentStatement");
+			array("left", s.variables);
+			if (s.expressions)
+				array("right", *s.expressions);
+			endObject();
+		}
+
+		void write(const ReturnStatement& s)
+		{
+			beginObject("ReturnStatement");
+			if (s.expressions.empty())
+			{
+				key("argument");
+				m_out += "[null]";
+				m_needComma = true;
+			}
+			else
+				array("argument", s.expressions);
+			endObject();
+		}
+
+		void write(const Block& b)
+		{
+			beginObject("Block", &b);
+			key("body");
+			if (b.statements.empty() && !b.returnStatement)
+				null();
+			else
+			{
+				beginArray();
+				for (const auto& statement : b.statements)
+					visit(statement);
+				if (b.returnStatement)
+					write(*b.returnStatement);
+				endArray();
+			}
+			endObject();
+		}
+
+	private:
+		static const char* getString(Operation op)
+		{
+			static const char* constants[] = {
+				"+", "-", "*", "/", "//", "%",
+				"^", "-", "&", "|", "~", "~",
+				"<<", ">>", "..", "#", "<",
+				"<=", ">", ">=", "==", "~=", "not",
+				"and", "or"};
+
+			return constants[static_cast<int>(op)];
+		}
+
+		template <class Variant>
+		void visit(const Variant& variant)
+		{
+			boost::apply_visitor([this](const auto& v) { write(v); }, variant);
+		}
+
+		// The printer writes null instead of an empty array
+		template <class T>
+		void array(const char* name, const std::vector<T>& list)
+		{
+			key(name);
+			if (list.empty())
+			{
+				null();
+				return;
+			}
+
+			beginArray();
+			for (const auto& item : list)
+				write(item);
+			endArray();
+		}
+
+		void stringArray(const char* name, const std::vector<std::string>& list)
+		{
+			key(name);
+			if (list.empty())
+			{
+				null();
+				return;
+			}
+
+			beginArray();
+			for (const auto& item : list)
+				string(item);
+			endArray();
+		}
+
+		void separator()
+		{
+			if (m_needComma)
+				m_out += ',';
+			m_needComma = true;
+		}
+
+		void beginObject(const char* type, const PositionAnnotated* position = nullptr)
+		{
+			const auto operandPosition = std::exchange(m_operandPosition, nullptr);
+			if (!position)
+				position = operandPosition;
+
+			separator();
+			m_out += '{';
+			m_needComma = false;
+
+			if (type)
+			{
+				key("type");
+				string(type);
+			}
+
+			if (m_withPositions && position)
+			{
+				key("begin");
+				number(position->begin);
+				key("end");
+				number(position->end);
+			}
+		}
+
+		void endObject()
+		{
+			m_out += '}';
+			m_needComma = true;
+
+			if (m_stream && m_out.size() >= chunkSize)
+				flush();
+		}
+
+		void beginArray()
+		{
+			separator();
+			m_out += '[';
+			m_needComma = false;
+		}
+
+		void endArray()
+		{
+			m_out += ']';
+			m_needComma = true;
+		}
+
+		void key(const char* name)
+		{
+			separator();
+			m_out += '"';
+			m_out += name;
+			m_out += "\":";
+			m_needComma = false;
+		}
+
+		void null()
+		{
+			separator();
+			m_out += "null";
+		}
+
+		template <class T>
+		void number(T value)
+		{
+			separator();
+
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				if (!std::isfinite(value))
+				{
+					m_out += "null"; // Same as nlohmann
+					return;
+				}
+			}
+
+			char buffer[32];
+			const auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+			m_out.append(buffer, end);
+
+			// Keep the number as a float when reading it back
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				if (std::find_if(buffer, end, [](char c) { return c == '.' || c == 'e'; }) == end)
+					m_out += ".0";
+			}
+		}
+
+		// The bytes are copied as is, only the characters that are not allowed in json strings are escaped
+		void string(std::string_view text)
+		{
+			separator();
+			m_out += '"';
+
+			size_t start = 0;
+			for (size_t i = 0; i < text.size(); ++i)
+			{
+				const auto c = static_cast<unsigned char>(text[i]);
+				if (c >= 0x20 && c != '"' && c != '\\')
+					continue;
+
+				m_out.append(text, start, i - start);
+				start = i + 1;
+				switch (c)
+				{
+				case '"':
+					m_out += "\\\"";
+					break;
+				case '\\':
+					m_out += "\\\\";
+					break;
+				case '\b':
+					m_out += "\\b";
+					break;
+				case '\f':
+					m_out += "\\f";
+					break;
+				case '\n':
+					m_out += "\\n";
+					break;
+				case '\r':
+					m_out += "\\r";
+					break;
+				case '\t':
+					m_out += "\\t";
+					break;
+				default:
+				{
+					static const char* hex = "0123456789abcdef";
+					m_out += "\\u00";
+					m_out += hex[c >> 4];
+					m_out += hex[c & 0xF];
+					break;
+				}
+				}
+			}
+
+			m_out.append(text, start, text.size() - start);
+			m_out += '"';
+		}
+
+		std::string& m_out;
+		std::ostream* m_stream = nullptr;
+		bool m_withPositions = false;
+		bool m_needComma = false;
+		const PositionAnnotated* m_operandPosition = nullptr;
+	};
+
+	template <class T>
+	void writeJsonToBuffer(std::string& buffer, const T& node, bool withPositions)
+	{
+		JsonWriter writer{buffer, withPositions};
+		writer.write(node);
+	}
+
+	template <class T>
+	void writeJsonToStream(std::ostream& stream, const T& node, bool withPositions)
+	{
+		std::string buffer;
+		buffer.reserve(chunkSize + chunkSize / 4);
+		JsonWriter writer{buffer, withPositions, &stream};
+		writer.write(node);
+		writer.flush();
+	}
+
+	void writeJson(std::string& buffer, const ast::Expression& ex, bool withPositions)
+	{
+		writeJsonToBuffer(buffer, ex, withPositions);
+	}
+
+	void writeJson(std::string& buffer, const ast::Block& block, bool withPositions)
+	{
+		writeJsonToBuffer(buffer, block, withPositions);
+	}
+
+	void writeJson(std::ostream& stream, const ast::Expression& ex, bool withPositions)
+	{
+		writeJsonToStream(stream, ex, withPositions);
+	}
+
+	void writeJson(std::ostream& stream, const ast::Block& block, bool withPositions)
+	{
+		writeJsonToStream(stream, block, withPositions);
+	}
+
+#ifdef WITH_NLOHMANN_JSON
+	TEST_CASE("Json writer")
+	{
+		const std::string program = R"~~(
+local a, b = 42, 3.5e3
+local t = { x = 1, [a] = [[text
+"quoted"]], 2.0; y = { } }
+function t.f:g(x, y, ...)
+	if x > y then return x elseif x == y then return else return -y end
+end
+while a < 10 do a = a + 1 end
+repeat b = b // 2 until b < 1
+for i = 1, 10, 2 do print(i, t[i], t.x:len()) end
+for k, v in pairs(t) do ::continue:: goto continue end
+do local function f() return ... end break end
+print "text" (t) { 1 }
+)~~";
+
+		const auto ret = parser::parseBlock(program);
+		REQUIRE(ret.parsed);
+
+		// Same json as the printer
+		std::string buffer;
+		writeJson(buffer, ret.block);
+		CHECK(nlohmann::json::parse(buffer) == nlohmann::json::parse(toJson(ret.block)));
+
+		std::ostringstream stream;
+		writeJson(stream, ret.block);
+		CHECK(stream.str() == buffer);
+
+		// With positions
+		buffer.clear();
+		writeJson(buffer, ret.block, true);
+		const auto json = nlohmann::json::parse(buffer);
+		CHECK(json["begin"] == ret.block.begin);
+		CHECK(json["end"] == ret.block.end);
+		const auto& local = json["body"][0];
+		CHECK(local["right"][0]["left"]["type"] == "Numeral");
+		CHECK(local["right"][0]["left"]["begin"] == program.find("42"));
+		CHECK(local["right"][1]["left"]["value"] == 3500.0);
+
+		// Strings are escaped
+		const auto& table = json["body"][1]["right"][0]["left"];
+		CHECK(table["type"] == "TableConstructor");
+		CHECK(table["begin"] == program.find('{'));
+		CHECK(table["fields"]["fields"][1]["value"]["left"]["value"] == "text\n\"quoted\"");
+
+		// Logical operators
+		const auto logical = parser::parseBlock("x = not a and b or c");
+		REQUIRE(logical.parsed);
+		buffer.clear();
+		writeJson(buffer, logical.block);
+		const auto logicalJson = nlohmann::json::parse(buffer);
+		CHECK(logicalJson == nlohmann::json::parse(toJson(logical.block)));
+		const auto& notOp = logicalJson["body"][0]["right"][0]["left"];
+		CHECK(notOp["operator"] == "not");
+		const auto& andOp = notOp["argument"]["right"];
+		CHECK(andOp["operator"] == "and");
+		CHECK(andOp["argument"]["right"]["operator"] == "or");
+	}
+#endif
+} // namespace lac
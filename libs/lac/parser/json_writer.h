@@ -0,0 +1,19 @@
+#pragma once
+
+#include <lac/parser/ast.h>
+#include <lac/core_api.h>
+
+#include <iosfwd>
+#include <string>
+
+namespace lac
+{
+	// Same json as toJson from printer.h, but written directly without creating a document.
+	// The output is compact, and can contain the positions of the annotated nodes ("begin" and "end" keys).
+	CORE_API void writeJson(std::string& buffer, const ast::Expression& ex, bool withPositions = false);
+	CORE_API void writeJson(std::string& buffer, const ast::Block& block, bool withPositions = false);
+
+	// The json is written by chunks in the stream
+	CORE_API void writeJson(std::ostream& stream, const ast::Expression& ex, bool withPositions = false);
+	CORE_API void writeJson(std::ostream& stream, const ast::Block& block, bool withPositions = false);
+} // namespace lac
@@ -0,0 +1,343 @@
+#include <lac/parser/lexer.h>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace
+{
+	constexpr auto npos = std::string_view::npos;
+
+	bool isNameStart(char c)
+	{
+		const auto ch = static_cast<unsigned char>(c);
+		return std::isalpha(ch) || ch == '_';
+	}
+
+	bool isNameChar(char c)
+	{
+		const auto ch = static_cast<unsigned char>(c);
+		return std::isalnum(ch) || ch == '_';
+	}
+
+	bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	bool isKeyword(std::string_view name)
+	{
+		// Must be sorted
+		static const std::string_view keywords[] = {
+			"and", "break", "do", "else", "elseif", "end", "false", "for", "function", "goto", "if",
+			"in", "local", "nil", "not", "or", "repeat", "return", "then", "true", "until", "while"};
+		return std::binary_search(std::begin(keywords), std::end(keywords), name);
+	}
+
+	// Test if a long bracket ("[[", "[=[", ...) starts at this position. Return its level or -1.
+	int longBracketLevel(std::string_view line, size_t pos, size_t& end)
+	{
+		if (pos >= line.size() || line[pos] != '[')
+			return -1;
+
+		auto p = pos + 1;
+		int level = 0;
+		while (p < line.size() && line[p] == '=')
+		{
+			++level;
+			++p;
+		}
+
+		if (p < line.size() && line[p] == '[')
+		{
+			end = p + 1;
+			return level;
+		}
+
+		return -1;
+	}
+
+	// Return the position after the closing long bracket of this level, or npos
+	size_t findLongBracketEnd(std::string_view line, size_t pos, int level)
+	{
+		while ((pos = line.find(']', pos)) != npos)
+		{
+			auto p = pos + 1;
+			int n = 0;
+			while (p < line.size() && line[p] == '=')
+			{
+				++n;
+				++p;
+			}
+
+			if (n == level && p < line.size() && line[p] == ']')
+				return p + 1;
+
+			++pos;
+		}
+
+		return npos;
+	}
+
+	size_t numeralEnd(std::string_view line, size_t pos)
+	{
+		const bool hex = line[pos] == '0' && pos + 1 < line.size() && (line[pos + 1] == 'x' || line[pos + 1] == 'X');
+		auto p = hex ? pos + 2 : pos;
+		while (p < line.size())
+		{
+			const auto c = line[p];
+			if (hex ? (c == 'p' || c == 'P') : (c == 'e' || c == 'E'))
+			{
+				++p;
+				if (p < line.size() && (line[p] == '+' || line[p] == '-'))
+					++p;
+			}
+			else if ((hex ? std::isxdigit(static_cast<unsigned char>(c)) : isDigit(c)) || c == '.')
+				++p;
+			else
+				break;
+		}
+
+		return p;
+	}
+} // namespace
+
+namespace lac::parser
+{
+	int LexerState::toInt() const
+	{
+		if (kind == Kind::normal)
+			return -1;
+
+		return level * 2 + (kind == Kind::longComment ? 1 : 0);
+	}
+
+	LexerState LexerState::fromInt(int value)
+	{
+		if (value < 0)
+			return {};
+
+		LexerState state;
+		state.kind = (value & 1) ? Kind::longComment : Kind::longString;
+		state.level = value >> 1;
+		return state;
+	}
+
+	LexerState lexLine(std::string_view line, LexerState state, Tokens& tokens)
+	{
+		const auto size = line.size();
+		auto addToken = [&tokens](size_t begin, size_t end, ast::ElementType type) {
+			if (begin < end)
+				tokens.push_back({begin, end, type});
+		};
+
+		// Long bracket until the end of the line or until it is closed
+		auto longBracket = [&](size_t begin, size_t searchPos, LexerState longState) {
+			const auto type = longState.kind == LexerState::Kind::longComment
+								  ? ast::ElementType::comment
+								  : ast::ElementType::literal_string;
+			const auto end = findLongBracketEnd(line, searchPos, longState.level);
+			if (end == npos)
+			{
+				addToken(begin, size, type);
+				state = longState;
+				return size;
+			}
+
+			addToken(begin, end, type);
+			state = {};
+			return end;
+		};
+
+		size_t pos = 0;
+		if (state.kind != LexerState::Kind::normal)
+			pos = longBracket(0, 0, state);
+
+		while (pos < size)
+		{
+			const auto c = line[pos];
+			size_t openEnd = 0;
+			if (c == '-' && pos + 1 < size && line[pos + 1] == '-')
+			{
+				const auto level = longBracketLevel(line, pos + 2, openEnd);
+				if (level >= 0)
+				{
+					pos = longBracket(pos, openEnd, {LexerState::Kind::longComment, level});
+					continue;
+				}
+
+				addToken(pos, size, ast::ElementType::comment);
+				break;
+			}
+			else if (c == '[')
+			{
+				const auto level = longBracketLevel(line, pos, openEnd);
+				if (level >= 0)
+					pos = longBracket(pos, openEnd, {LexerState::Kind::longString, level});
+				else
+					++pos;
+			}
+			else if (c == '\'' || c == '"')
+			{
+				auto p = pos + 1;
+				while (p < size && line[p] != c)
+				{
+					if (line[p] == '\\')
+						++p; // Ignore the escaped character
+					++p;
+				}
+
+				const auto end = std::min(p + 1, size);
+				addToken(pos, end, ast::ElementType::literal_string);
+				pos = end;
+			}
+			else if (isDigit(c) || (c == '.' && pos + 1 < size && isDigit(line[pos + 1])))
+			{
+				const auto end = numeralEnd(line, pos);
+				addToken(pos, end, ast::ElementType::numeral);
+				pos = end;
+			}
+			else if (isNameStart(c))
+			{
+				auto end = pos + 1;
+				while (end < size && isNameChar(line[end]))
+					++end;
+
+				const auto type = isKeyword(line.substr(pos, end - pos))
+									  ? ast::ElementType::keyword
+									  : ast::ElementType::variable;
+				addToken(pos, end, type);
+				pos = end;
+			}
+			else
+				++pos;
+		}
+
+		return state;
+	}
+
+	Tokens lexText(std::string_view text)
+	{
+		Tokens tokens;
+		LexerState state;
+		size_t lineStart = 0;
+		while (lineStart <= text.size())
+		{
+			auto lineEnd = text.find('\n', lineStart);
+			if (lineEnd == std::string_view::npos)
+				lineEnd = text.size();
+
+			const auto first = tokens.size();
+			state = lexLine(text.substr(lineStart, lineEnd - lineStart), state, tokens);
+			for (auto i = first; i < tokens.size(); ++i)
+			{
+				tokens[i].begin += lineStart;
+				tokens[i].end += lineStart;
+			}
+
+			lineStart = lineEnd + 1;
+		}
+
+		return tokens;
+	}
+
+	TEST_SUITE_BEGIN("Lexer");
+
+	TEST_CASE("Lexer state conversion")
+	{
+		CHECK(LexerState{}.toInt() == -1);
+		CHECK(LexerState::fromInt(-1).kind == LexerState::Kind::normal);
+
+		for (auto kind : {LexerState::Kind::longString, LexerState::Kind::longComment})
+		{
+			for (int level = 0; level < 4; ++level)
+			{
+				const auto state = LexerState::fromInt(LexerState{kind, level}.toInt());
+				CHECK(state.kind == kind);
+				CHECK(state.level == level);
+			}
+		}
+	}
+
+	TEST_CASE("Lex single line")
+	{
+		Tokens tokens;
+		const auto state = lexLine("local x = 'a\\'b' .. 0x1F + 3.5e-2 -- comment", {}, tokens);
+		CHECK(state.kind == LexerState::Kind::normal);
+		REQUIRE(tokens.size() == 6);
+
+		CHECK(tokens[0].type == ast::ElementType::keyword);
+		CHECK(tokens[0].begin == 0);
+		CHECK(tokens[0].end == 5);
+
+		CHECK(tokens[1].type == ast::ElementType::variable);
+		CHECK(tokens[2].type == ast::ElementType::literal_string);
+		CHECK(tokens[2].begin == 10);
+		CHECK(tokens[2].end == 16);
+
+		CHECK(tokens[3].type == ast::ElementType::numeral);
+		CHECK(tokens[3].end - tokens[3].begin == 4);
+		CHECK(tokens[4].type == ast::ElementType::numeral);
+		CHECK(tokens[4].end - tokens[4].begin == 6);
+		CHECK(tokens[5].type == ast::ElementType::comment);
+		CHECK(tokens[5].end == 44);
+	}
+
+	TEST_CASE("Lex multiple lines")
+	{
+		Tokens tokens;
+		auto state = lexLine("s = [==[ start", {}, tokens);
+		CHECK(state.kind == LexerState::Kind::longString);
+		CHECK(state.level == 2);
+		REQUIRE(tokens.size() == 2);
+		CHECK(tokens[1].type == ast::ElementType::literal_string);
+
+		// ]] does not close a level 2 long string
+		tokens.clear();
+		state = lexLine("middle ]] ]=]", state, tokens);
+		CHECK(state.kind == LexerState::Kind::longString);
+		REQUIRE(tokens.size() == 1);
+		CHECK(tokens[0].end == 13);
+
+		tokens.clear();
+		state = lexLine("end ]==] --[[ comment", state, tokens);
+		CHECK(state.kind == LexerState::Kind::longComment);
+		CHECK(state.level == 0);
+		REQUIRE(tokens.size() == 2);
+		CHECK(tokens[0].type == ast::ElementType::literal_string);
+		CHECK(tokens[0].end == 8);
+		CHECK(tokens[1].type == ast::ElementType::comment);
+		CHECK(tokens[1].begin == 9);
+
+		tokens.clear();
+		state = lexLine("]] while true do end", state, tokens);
+		CHECK(state.kind == LexerState::Kind::normal);
+		REQUIRE(tokens.size() == 5);
+		CHECK(tokens[0].type == ast::ElementType::comment);
+		CHECK(tokens[1].type == ast::ElementType::keyword);
+		CHECK(tokens[2].type == ast::ElementType::keyword);
+	}
+
+	TEST_CASE("Lex text")
+	{
+		const auto tokens = lexText("x = [[a\nb]] -- c\ny");
+		REQUIRE(tokens.size() == 5);
+
+		// One token by line for the long string
+		CHECK(tokens[1].type == ast::ElementType::literal_string);
+		CHECK(tokens[1].begin == 4);
+		CHECK(tokens[1].end == 7);
+		CHECK(tokens[2].type == ast::ElementType::literal_string);
+		CHECK(tokens[2].begin == 8);
+		CHECK(tokens[2].end == 11);
+
+		CHECK(tokens[3].type == ast::ElementType::comment);
+		CHECK(tokens[3].end == 16);
+		CHECK(tokens[4].type == ast::ElementType::variable);
+		CHECK(tokens[4].begin == 17);
+	}
+
+	TEST_SUITE_END();
+} // namespace lac::parser
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <lac/parser/ast.h>
+#include <lac/core_api.h>
+
+#include <string_view>
+#include <vector>
+
+namespace lac::parser
+{
+	// State of the lexer at the end of a line, for the constructs spanning multiple lines
+	struct CORE_API LexerState
+	{
+		enum class Kind
+		{
+			normal,
+			longString,
+			longComment
+		};
+
+		Kind kind = Kind::normal;
+		int level = 0; // Number of '=' in the long bracket
+
+		// Conversion to a single integer, the normal state being -1 (the default state of a QTextBlock)
+		int toInt() const;
+		static LexerState fromInt(int value);
+	};
+
+	struct CORE_API Token
+	{
+		size_t begin = 0, end = 0;
+		ast::ElementType type = ast::ElementType::not_defined; // Names are using the variable type
+	};
+	using Tokens = std::vector<Token>;
+
+	// Add the tokens found in the line, starting in the given state. Return the state at the end of the line.
+	CORE_API LexerState lexLine(std::string_view line, LexerState state, Tokens& tokens);
+
+	// Tokens of a whole text, their positions being relative to its beginning
+	CORE_API Tokens lexText(std::string_view text);
+} // namespace lac::parser
@@ -2,8 +2,83 @@
 #include <lac/parser/parser.h>
 #include <lac/parser/positions.h>
 
+#include <doctest/doctest.h>
+
+#include <algorithm>
+
+namespace
+{
+	using expectation_failure = boost::spirit::x3::expectation_failure<std::string_view::const_iterator>;
+
+	bool isNameLetter(char c)
+	{
+		const auto ch = static_cast<unsigned char>(c);
+		return std::isalnum(ch) || ch == '_';
+	}
+
+	// The word or the symbol at this position
+	std::string_view tokenAt(std::string_view view, size_t pos)
+	{
+		if (pos >= view.size())
+			return {};
+
+		auto end = pos + 1;
+		if (isNameLetter(view[pos]))
+		{
+			while (end < view.size() && isNameLetter(view[end]))
+				++end;
+		}
+		return view.substr(pos, end - pos);
+	}
+
+	// Convert the name of a rule or a literal to something the user understands
+	std::string describe(std::string_view expected)
+	{
+		constexpr std::pair<std::string_view, std::string_view> rules[] = {
+			{"expressionsList", "expression"},
+			{"namesList", "name"},
+			{"functionName", "function name"},
+			{"functionBody", "'('"},
+		};
+		constexpr std::string_view keywords[] = {"do", "end", "function", "in", "local", "then", "until", "while"};
+
+		for (const auto& rule : rules)
+		{
+			if (rule.first == expected)
+				return std::string{rule.second};
+		}
+
+		if (std::find(std::begin(keywords), std::end(keywords), expected) != std::end(keywords))
+			return "'" + std::string{expected} + "'";
+
+		// Literal strings are written with double quotes by X3
+		if (expected.size() > 1 && expected.front() == '"' && expected.back() == '"')
+			return "'" + std::string{expected.substr(1, expected.size() - 2)} + "'";
+
+		return std::string{expected};
+	}
+} // namespace
+
 namespace lac::parser
 {
+	Diagnostic createDiagnostic(std::string_view view, size_t offset, std::string_view expected)
+	{
+		// Point to the token, not to the spaces before it
+		while (offset < view.size() && std::isspace(static_cast<unsigned char>(view[offset])))
+			++offset;
+
+		Diagnostic diagnostic;
+		diagnostic.offset = offset;
+		diagnostic.expected = describe(expected);
+		diagnostic.found = tokenAt(view, offset);
+
+		const auto found = diagnostic.found.empty() ? std::string{"the end of the text"} : "'" + diagnostic.found + "'";
+		diagnostic.message = diagnostic.expected.empty()
+								 ? "Unexpected " + found
+								 : "Expected " + diagnostic.expected + " but found " + found;
+		return diagnostic;
+	}
+
 	ParseBlockResults::ParseBlockResults(std::string_view view)
 		: positions(view.begin(), view.end())
 	{
@@ -12,23 +87,34 @@ namespace lac::parser
 	ParseBlockResults parseBlock(std::string_view view, bool registerPositions)
 	{
 		ParseBlockResults res{view};
-		if (view.empty())
-			return res;
-
 		auto f = view.begin();
 		const auto l = view.end();
-		if (registerPositions)
+		try
 		{
-			const auto parser = boost::spirit::x3::with<lac::pos::position_tag>(std::ref(res.positions))[chunkRule()];
-			const auto skipper = boost::spirit::x3::with<lac::pos::position_tag>(std::ref(res.positions))[skipperRule()];
-			res.parsed = boost::spirit::x3::phrase_parse(f, l, parser, skipper, res.block) && f == l;
+			if (registerPositions)
+			{
+				// Avoid the reallocations of the elements, there is roughly one for 10 characters
+				res.positions.reserve(view.size() / 8);
+				const auto parser = boost::spirit::x3::with<lac::pos::position_tag>(std::ref(res.positions))[chunkRule()];
+				const auto skipper = boost::spirit::x3::with<lac::pos::position_tag>(std::ref(res.positions))[skipperRule()];
+				res.parsed = boost::spirit::x3::phrase_parse(f, l, parser, skipper, res.block) && f == l;
+			}
+			else
+			{
+				res.parsed = boost::spirit::x3::phrase_parse(f, l, chunkRule(), skipperRule(), res.block) && f == l;
+			}
 		}
-		else
+		catch (const expectation_failure& e)
 		{
-			res.parsed = boost::spirit::x3::phrase_parse(f, l, chunkRule(), skipperRule(), res.block) && f == l;
+			f = e.where();
+			res.diagnostics.push_back(createDiagnostic(view, f - view.begin(), e.which()));
 		}
 
 		res.lastParsedPosition = f - view.begin();
+		if (!res.parsed && res.diagnostics.empty())
+			res.diagnostics.push_back(createDiagnostic(view, res.lastParsedPosition));
+
+		res.positions.finalize();
 		return res;
 	}
 
@@ -40,7 +126,60 @@ namespace lac::parser
 
 		auto f = view.begin();
 		const auto l = view.end();
-		res.parsed = boost::spirit::x3::phrase_parse(f, l, variableOrFunctionRule(), skipperRule(), res.variable) && f == l;
+		try
+		{
+			res.parsed = boost::spirit::x3::phrase_parse(f, l, variableOrFunctionRule(), skipperRule(), res.variable) && f == l;
+		}
+		catch (const expectation_failure&)
+		{
+			res.parsed = false;
+		}
 		return res;
 	}
+
+	TEST_CASE("Diagnostics")
+	{
+		auto check = [](std::string_view program, size_t offset, std::string_view expected, std::string_view found) {
+			const auto res = parseBlock(program);
+			CHECK_FALSE(res.parsed);
+			REQUIRE(res.diagnostics.size() == 1);
+			const auto& diagnostic = res.diagnostics.front();
+			CHECK(diagnostic.offset == offset);
+			CHECK(diagnostic.expected == expected);
+			CHECK(diagnostic.found == found);
+		};
+
+		check("a = 1\nb = = 2", 10, "expression", "=");
+		check("if a then\nb = 1\nelse", 20, "'end'", "");
+		check("if a b = 1 end", 5, "'then'", "b");
+		check("while true\ndo x() enf", 18, "'end'", "enf");
+		check("local function f(a, b\nend", 22, "')'", "end");
+		check("local 1 = 2", 6, "name", "1");
+		check("for k v in pairs(t) do end", 6, "'in'", "v");
+		check("for i = 1 do end", 10, "','", "do");
+		check("t = { 1, 2", 10, "'}'", "");
+		check("print((a + b)", 13, "')'", "");
+		check("::label x = 1", 8, "'::'", "x");
+		check("function (a) end", 9, "function name", "(");
+		check("x = 1 )", 6, "", ")");
+
+		const auto res = parseBlock("a = 1\nb = = 2");
+		CHECK(res.lastParsedPosition == 9);
+		CHECK(res.diagnostics.front().message == "Expected expression but found '='");
+		CHECK(parseBlock("if a then").diagnostics.front().message == "Expected 'end' but found the end of the text");
+		CHECK(parseBlock("x = 1 )").diagnostics.front().message == "Unexpected ')'");
+
+		// The keywords are not the beginning of longer names
+		CHECK(parseBlock("local functional = 1").parsed);
+		CHECK(parseBlock("while done do doit() end").parsed);
+		CHECK(parseBlock("if x then ending = 1 end").parsed);
+		CHECK(parseBlock("for index = 1, 2 do end").parsed);
+		CHECK(parseBlock("x = { [[text]], [=[other]=] }").parsed);
+		CHECK(parseBlock("t = { a == b }").parsed);
+		CHECK(parseBlock("x = a\n(f)(1)").parsed);
+
+		// No exception for the variables
+		CHECK_FALSE(parseVariable("f(a").parsed);
+		CHECK_FALSE(parseVariable("(a").parsed);
+	}
 } // namespace lac::parser
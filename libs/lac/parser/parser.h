@@ -6,6 +6,16 @@
 
 namespace lac::parser
 {
+	// Syntax error. The parsing stops at the first one.
+	struct CORE_API Diagnostic
+	{
+		size_t offset = 0;    // Position of the token that was found
+		std::string expected; // Construct expected at this position, empty if we only know the token is not valid here
+		std::string found;    // Token at this position, empty at the end of the text
+		std::string message;
+	};
+	using Diagnostics = std::vector<Diagnostic>;
+
 	struct CORE_API ParseBlockResults
 	{
 		ParseBlockResults(std::string_view view);
@@ -14,9 +24,10 @@ namespace lac::parser
 		ast::Block block;
 		pos::Positions<std::string_view::const_iterator> positions;
 		size_t lastParsedPosition = 0;
+		Diagnostics diagnostics;
 	};
 
-	// These skip comments and spaces
+	// These skip comments and spaces. An empty text is a valid block.
 	CORE_API ParseBlockResults parseBlock(std::string_view view, bool registerPositions = true);
 
 	struct CORE_API ParseVariableResults
@@ -26,4 +37,17 @@ namespace lac::parser
 	};
 
 	CORE_API ParseVariableResults parseVariable(std::string_view view);
+
+	struct CORE_API ValidationResults
+	{
+		bool valid = false;
+		size_t lastParsedPosition = 0;
+		Diagnostics diagnostics;
+	};
+
+	// Only check the syntax, using the same grammar without creating the AST nor the positions.
+	CORE_API ValidationResults validateBlock(std::string_view view);
+
+	// Describe the syntax error at this position. The expected construct is given by the failed expectation point (a rule name or a literal).
+	CORE_API Diagnostic createDiagnostic(std::string_view view, size_t offset, std::string_view expected = {});
 } // namespace lac::parser
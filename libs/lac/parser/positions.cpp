@@ -1,5 +1,6 @@
 #include <lac/parser/ast_adapted.h>
 #include <lac/parser/chunk.h>
+#include <lac/parser/parser.h>
 
 #include <lac/helper/test_utils.h>
 
@@ -14,6 +15,7 @@ namespace
 		const auto parser = boost::spirit::x3::with<lac::pos::position_tag>(std::ref(positions))[p];
 		if (boost::spirit::x3::phrase_parse(f, l, parser, boost::spirit::x3::ascii::space, arg) && f == l)
 		{
+			positions.finalize();
 			elts = positions.elements();
 			return true;
 		}
@@ -23,6 +25,69 @@ namespace
 
 namespace lac
 {
+	namespace pos
+	{
+		SortedElements::SortedElements(Elements elements)
+			: m_elements(std::move(elements))
+		{
+			// Parents before their children, so that the latter are applied last
+			std::stable_sort(m_elements.begin(), m_elements.end(), [](const Element& lhs, const Element& rhs) {
+				return lhs.begin < rhs.begin || (lhs.begin == rhs.begin && lhs.end > rhs.end);
+			});
+
+			// Backtracking in the parser can register the same element multiple times, keep the last one
+			Elements unique;
+			unique.reserve(m_elements.size());
+			for (const auto& elt : m_elements)
+			{
+				if (!unique.empty() && unique.back().begin == elt.begin && unique.back().end == elt.end)
+					unique.back() = elt;
+				else
+					unique.push_back(elt);
+			}
+			m_elements = std::move(unique);
+
+			m_maxEnd.reserve(m_elements.size());
+			size_t maxEnd = 0;
+			for (const auto& elt : m_elements)
+			{
+				maxEnd = std::max(maxEnd, elt.end);
+				m_maxEnd.push_back(maxEnd);
+			}
+		}
+
+		const Elements& SortedElements::elements() const
+		{
+			return m_elements;
+		}
+
+		bool SortedElements::empty() const
+		{
+			return m_elements.empty();
+		}
+
+		Elements SortedElements::inRange(size_t begin, size_t end) const
+		{
+			// The first element that can end after the start of the range
+			const auto first = std::upper_bound(m_maxEnd.begin(), m_maxEnd.end(), begin) - m_maxEnd.begin();
+
+			// The first element starting after the end of the range
+			const auto last = std::lower_bound(m_elements.begin(), m_elements.end(), end, [](const Element& elt, size_t pos) {
+								  return elt.begin < pos;
+							  })
+							  - m_elements.begin();
+
+			Elements elements;
+			for (auto i = first; i < last; ++i)
+			{
+				const auto& elt = m_elements[i];
+				if (elt.end > begin)
+					elements.push_back(elt);
+			}
+			return elements;
+		}
+	} // namespace pos
+
 	using helper::test_phrase_parser;
 
 	TEST_CASE("Positions")
@@ -80,4 +145,83 @@ namespace lac
 		CHECK(var.begin == 0);
 		CHECK(var.end == 4);
 	}
+
+	TEST_CASE("Elements in range")
+	{
+		const auto ret = parser::parseBlock("testVar = 'hello' .. 42\n--[[ long\ncomment ]] x = 1");
+		REQUIRE(ret.parsed);
+		const auto& elements = ret.positions.elements();
+
+		pos::SortedElements sorted{elements};
+		for (size_t i = 1; i < sorted.elements().size(); ++i)
+			CHECK(sorted.elements()[i - 1].begin <= sorted.elements()[i].begin);
+
+		auto inRange = sorted.inRange(0, 8);
+		REQUIRE(inRange.size() == 1);
+		CHECK(inRange[0].type == ast::ElementType::variable);
+
+		inRange = sorted.inRange(12, 22);
+		REQUIRE(inRange.size() == 2);
+		CHECK(inRange[0].type == ast::ElementType::literal_string);
+		CHECK(inRange[1].type == ast::ElementType::numeral);
+
+		// The comment starts on the previous line
+		inRange = sorted.inRange(33, 40);
+		REQUIRE(inRange.size() == 1);
+		CHECK(inRange[0].type == ast::ElementType::comment);
+
+		CHECK(sorted.inRange(100, 200).empty());
+		CHECK(pos::SortedElements{}.inRange(0, 10).empty());
+	}
+
+	TEST_CASE("Elements with UTF-8")
+	{
+		// "é" and "ü" are 2 bytes long, the positions are in bytes
+		const auto ret = parser::parseBlock("s = 'héllo' -- commentaire été\nt = [[ü]]");
+		REQUIRE(ret.parsed);
+
+		pos::SortedElements sorted{ret.positions.elements()};
+		const auto& elements = sorted.elements();
+		REQUIRE(elements.size() == 5);
+
+		CHECK(elements[1].type == ast::ElementType::literal_string);
+		CHECK(elements[1].begin == 4);
+		CHECK(elements[1].end == 12);
+
+		CHECK(elements[2].type == ast::ElementType::comment);
+		CHECK(elements[2].begin == 13);
+
+		CHECK(elements[3].type == ast::ElementType::variable);
+		CHECK(elements[3].begin == 34);
+
+		CHECK(elements[4].type == ast::ElementType::literal_string);
+		CHECK(elements[4].begin == 38);
+		CHECK(elements[4].end == 44);
+	}
+
+	TEST_CASE("Elements registered while backtracking")
+	{
+		// The arguments are parsed a first time as part of a variable, then again for the function call
+		const std::string program = "print 'text' (t) { 1 }";
+		const auto ret = parser::parseBlock(program);
+		REQUIRE(ret.parsed);
+
+		const auto& elements = ret.positions.elements();
+		REQUIRE(elements.size() == 5);
+		for (size_t i = 1; i < elements.size(); ++i)
+		{
+			const auto& prev = elements[i - 1];
+			const auto& elt = elements[i];
+			CHECK((prev.end < elt.end || (prev.end == elt.end && prev.begin > elt.begin)));
+		}
+
+		auto text = [&](size_t index) {
+			return program.substr(elements[index].begin, elements[index].end - elements[index].begin);
+		};
+		CHECK(text(0) == "print");
+		CHECK(text(1) == "'text'");
+		CHECK(text(2) == "(t)");
+		CHECK(text(3) == "1");
+		CHECK(text(4) == "{ 1 }");
+	}
 } // namespace lac
@@ -1,10 +1,10 @@
 #pragma once
 
 #include <lac/parser/ast.h>
-#include <lac/helper/algorithm.h>
 
 #include <boost/spirit/home/x3/support/context.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -78,6 +78,24 @@ namespace lac
 		};
 		using Elements = std::vector<Element>;
 
+		// Elements sorted by their position, to quickly get those overlapping a range of the text
+		class CORE_API SortedElements
+		{
+		public:
+			SortedElements() = default;
+			SortedElements(Elements elements);
+
+			const Elements& elements() const;
+			bool empty() const;
+
+			// Return the elements overlapping [begin, end), in the order of their start position
+			Elements inRange(size_t begin, size_t end) const;
+
+		private:
+			Elements m_elements;
+			std::vector<size_t> m_maxEnd; // For each index, the maximum end of the elements before it (included)
+		};
+
 		template <typename Iterator>
 		class Positions
 		{
@@ -115,23 +133,37 @@ namespace lac
 				addElement(elt);
 			}
 
+			void reserve(size_t nbElements)
+			{
+				m_elements.reserve(nbElements);
+			}
+
+			// The elements are only appended during the parsing, finalize must be called before reading them
 			void addElement(Element element)
 			{
-				for (auto& elt : helper::reverse{m_elements})
+				m_elements.push_back(element);
+			}
+
+			// Sort the elements by end position, and by decreasing start position for the same end (children before their parent).
+			// Backtracking in the parser can register the same element multiple times, only the last one is kept.
+			void finalize()
+			{
+				std::stable_sort(m_elements.begin(), m_elements.end(), [](const Element& lhs, const Element& rhs) {
+					return lhs.end < rhs.end || (lhs.end == rhs.end && lhs.begin > rhs.begin);
+				});
+
+				auto last = m_elements.begin();
+				for (auto it = m_elements.begin(); it != m_elements.end(); ++it)
 				{
-					if (elt.end < element.begin)
-						break; // We can stop the search
-
-					if (elt.begin == element.begin && elt.end == element.end)
-					{
-						elt = element;
-						return;
-					}
+					if (last != it && (last->begin != it->begin || last->end != it->end))
+						++last;
+					*last = *it;
 				}
-
-				m_elements.push_back(element);
+				if (!m_elements.empty())
+					m_elements.erase(last + 1, m_elements.end());
 			}
 
+			// Only sorted after a call to finalize
 			const Elements& elements() const
 			{
 				return m_elements;
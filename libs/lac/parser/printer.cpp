@@ -13,7 +13,8 @@ namespace lac
 				"+", "-", "*", "/", "//", "%",
 				"^", "-", "&", "|", "~", "~",
 				"<<", ">>", "..", "#", "<",
-				"<=", ">", ">=", "==", "~="};
+				"<=", ">", ">=", "==", "~=", "not",
+				"and", "or"};
 
 			return constants[static_cast<int>(op)];
 		}
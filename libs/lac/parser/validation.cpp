@@ -0,0 +1,78 @@
+#define LAC_VALIDATION_GRAMMAR
+#include <lac/parser/chunk_def.h>
+#undef LAC_VALIDATION_GRAMMAR
+
+#include <lac/parser/parser.h>
+
+#include <doctest/doctest.h>
+
+namespace lac::parser
+{
+	ValidationResults validateBlock(std::string_view view)
+	{
+		ValidationResults res;
+		auto f = view.begin();
+		const auto l = view.end();
+		try
+		{
+			res.valid = boost::spirit::x3::phrase_parse(f, l, validation::chunk, validation::skipper) && f == l;
+		}
+		catch (const boost::spirit::x3::expectation_failure<std::string_view::const_iterator>& e)
+		{
+			f = e.where();
+			res.diagnostics.push_back(createDiagnostic(view, f - view.begin(), e.which()));
+		}
+
+		res.lastParsedPosition = f - view.begin();
+		if (!res.valid && res.diagnostics.empty())
+			res.diagnostics.push_back(createDiagnostic(view, res.lastParsedPosition));
+		return res;
+	}
+
+	TEST_CASE("Validation")
+	{
+		// Same results as the parser
+		const std::vector<std::string> programs = {
+			"local a, b = 42, -3.5e3",
+			"local t = { x = 1, [a] = [[text]], 2.0; y = { } } -- comment",
+			"function t.f:g(x, y, ...) if x > y then return x elseif x == y then return else return -y end end",
+			"while a < 10 do a = a + 1 end --[[ long\n comment ]]",
+			"repeat b = b // 2 until not (b >= 1)",
+			"for i = 1, 10, 2 do print(i, t[i], t.x:len()) end",
+			"for k, v in pairs(t) do ::continue:: goto continue end",
+			"do local function f() return ... end break end",
+			"print 'text' (t) { 1 }",
+			"a = 1\nb = = 2",
+			"if a then\nb = 1\nelse",
+			"local function f(a, b\nend",
+			"x = 'unfinished",
+			"a.b:c = 3",
+			"local 1 = 2",
+			"",
+			"-- Only a comment"};
+
+		for (const auto& program : programs)
+		{
+			const auto parsed = parseBlock(program);
+			const auto validated = validateBlock(program);
+			CHECK(validated.valid == parsed.parsed);
+			CHECK(validated.lastParsedPosition == parsed.lastParsedPosition);
+			REQUIRE(validated.diagnostics.size() == parsed.diagnostics.size());
+			for (size_t i = 0; i < parsed.diagnostics.size(); ++i)
+				CHECK(validated.diagnostics[i].message == parsed.diagnostics[i].message);
+		}
+
+		auto res = validateBlock("a = 1\nb = = 2");
+		CHECK_FALSE(res.valid);
+		CHECK(res.lastParsedPosition == 9);
+		REQUIRE(res.diagnostics.size() == 1);
+		CHECK(res.diagnostics[0].offset == 10);
+		CHECK(res.diagnostics[0].message == "Expected expression but found '='");
+
+		res = validateBlock("x = 1 )");
+		CHECK_FALSE(res.valid);
+		REQUIRE(res.diagnostics.size() == 1);
+		CHECK(res.diagnostics[0].offset == 6);
+		CHECK(res.diagnostics[0].message == "Unexpected ')'");
+	}
+} // namespace lac::parser